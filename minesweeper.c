@@ -10,17 +10,34 @@
  */
 
 #include <ncurses.h>
+#include <pthread.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <getopt.h>
 #include <time.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 //
 // The underlying data storage for each cell
 //
 typedef int8_t TCell;
 
+//
+// The type used for board dimensions, coordinates, and cell counters.
+// Kept separate from the cell-value type so board sizes are not capped
+// by the 8-bit cell storage.
+//
+typedef int32_t TIndex;
+
 //
 // Static status strings
 //
@@ -40,662 +57,4087 @@ static const TCell WRONG_FLAG = 'X';
 static const TCell BLANK = 0;
 
 //
-// Generate a random integer in the range [start, end)
+// Pluggable PRNG state: xoshiro256** seeded via splitmix64. Replaces the
+// modulo-biased rand(), and supports deterministic seeding so benchmark
+// boards are reproducible. Thread-local, so parallel simulation workers
+// each run an independent stream.
+//
+static __thread uint64_t rngState[4];
+
+//
+// splitmix64 step, used to expand a single seed into the PRNG state
+//
+static uint64_t splitmix64(uint64_t * const state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+//
+// Seed the PRNG deterministically
+//
+void seed_random(uint64_t seed)
+{
+    for (int i = 0 ; i < 4 ; ++i)
+    {
+        rngState[i] = splitmix64(&seed);
+    }
+}
+
+//
+// Rotate left helper for the xoshiro step
+//
+static uint64_t rotl64(const uint64_t x, const int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+//
+// Generate the next 64 random bits (xoshiro256** step)
 //
-TCell random(const int start = 0, const int end = RAND_MAX)
+uint64_t random64()
+{
+    const uint64_t result = rotl64(rngState[1] * 5, 7) * 9;
+    const uint64_t t = rngState[1] << 17;
+
+    rngState[2] ^= rngState[0];
+    rngState[3] ^= rngState[1];
+    rngState[1] ^= rngState[2];
+    rngState[0] ^= rngState[3];
+    rngState[2] ^= t;
+    rngState[3] = rotl64(rngState[3], 45);
+
+    return result;
+}
+
+//
+// Generate a random integer in the range [start, end), using a
+// fixed-point multiply instead of a biased modulo reduction
+//
+TIndex random(const TIndex start = 0, const TIndex end = RAND_MAX)
 {
     if (start < 0 || end < 1 || start >= end)
-        return ERROR;
+        return (TIndex) ERROR;
 
-    int range = end - start;
-    int r = rand() % range;
-    r += start;
+    const uint64_t range = (uint64_t) (end - start);
+    const TIndex r = (TIndex) (((random64() >> 32) * range) >> 32);
 
-    return (TCell) r;
+    return start + r;
 }
 
 //
-// Structure to represent the minesweeper grid of cells, and their state
+// Storage for a single cell: the mine value and the player input state
+// live side by side, so the hot grid passes that need both touch one
+// cache line per cell instead of two
 //
-struct SBoard
+struct SCell
 {
-private:
+    TCell val;
+    TCell input;
+};
 
-    // Current cursor position
-    TCell curY;
-    TCell curX;
+//
+// Difficulty presets selectable from the command line
+//
+struct SPreset
+{
+    const char * name;
+    TIndex height;
+    TIndex width;
+    TIndex mines;
+};
 
-    // Game state
-    bool done;
-    bool win;
-    bool lose;
-    TCell revealCount;
-    TCell flagCount;
+static constexpr SPreset PRESETS[] =
+{
+    { "Beginner",      8,  8, 10 },
+    { "Intermediate", 16, 16, 40 },
+    { "Expert",       16, 30, 99 },
+};
 
-    // Board dimensions
-    const TCell height;
-    const TCell width;
-    const TCell mines;
+//
+// Validate a board geometry against the limits of the index type: all
+// dimensions positive, the total cell count must fit in TIndex, and at
+// least one cell must stay mine-free
+//
+bool valid_geometry(const TIndex height, const TIndex width,
+                    const TIndex mines)
+{
+    if (height < 1 || width < 1 || mines < 1)
+    {
+        return false;
+    }
 
-    // Cell states
-    TCell * board = NULL;
-    TCell * input_board = NULL;
+    if ((int64_t) height * (int64_t) width > (int64_t) INT32_MAX)
+    {
+        return false;
+    }
 
-    // Timestamp when the game is started
-    struct timespec startTime;
+    if ((int64_t) mines >= (int64_t) height * (int64_t) width)
+    {
+        return false;
+    }
 
-    // Handles to the ncurses windows
-    WINDOW * pScore;
-    WINDOW * pField;
+    return true;
+}
 
-    // Unused default constructor
-    SBoard() : height(0), width(0), mines(0) {}
+//
+// Snapshot file format: one SSnapshotHeader followed by the raw bitset
+// and cell regions of the board's backing block, so saving is a handful
+// of contiguous writes and restoring reads straight into the backing
+// buffer with no per-cell parsing
+//
+static const uint32_t SNAPSHOT_MAGIC = 0x4D53534E;   // "MSSN"
+static const uint32_t SNAPSHOT_VERSION = 1;
 
-public:
+struct SSnapshotHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    TIndex height;
+    TIndex width;
+    TIndex mines;
+    TIndex curY;
+    TIndex curX;
+    TIndex revealCount;
+    TIndex flagCount;
+    uint8_t done;
+    uint8_t win;
+    uint8_t lose;
+    uint8_t pad;
+    uint64_t elapsed_ms;
+};
 
-    //
-    // Constructor for the minesweeper board
-    //
-    SBoard( const TCell height,
-            const TCell width,
-            const TCell mines,
-            WINDOW * const pScoreWin,
-            WINDOW * const pFieldWin)
-    : height(height), width(width), mines(mines), pScore(pScoreWin), pField(pFieldWin)
+//
+// Persistent lifetime statistics. Every finished game appends one
+// fixed-size binary record, and the aggregate header at the front of the
+// file is memory mapped and bumped in place as each record lands, so
+// lifetime totals read back in O(1) without walking the record log.
+// Field sizes and order are chosen so neither struct carries hidden
+// padding; the header is 64 bytes and each record 32.
+//
+static const uint32_t STATS_MAGIC = 0x4D535354;   // "MSST"
+static const uint32_t STATS_VERSION = 1;
+
+struct SStatsHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t games;
+    uint64_t wins;
+    uint64_t losses;
+    uint64_t total_elapsed_ms;
+    uint64_t total_revealed;
+    uint64_t total_flagged;
+    uint64_t best_win_ms;
+};
+
+struct SStatsRecord
+{
+    TIndex height;
+    TIndex width;
+    TIndex mines;
+    uint8_t win;
+    uint8_t pad[3];
+    uint64_t elapsed_ms;
+    TIndex revealCount;
+    TIndex flagCount;
+};
+
+static SStatsHeader * statsHeader = NULL;
+static int statsFd = -1;
+
+//
+// Open (creating if needed) the stats file and map its aggregate header
+// into memory
+//
+bool stats_open(const char * const path)
+{
+    statsFd = open(path, O_RDWR | O_CREAT, 0644);
+
+    if (statsFd < 0)
     {
-        curY = 0;
-        curX = 0;
+        return false;
+    }
 
-        init();
+    struct stat st;
+
+    if (fstat(statsFd, &st) != 0)
+    {
+        close(statsFd);
+        statsFd = -1;
+        return false;
     }
 
-    //
-    // Initialize the minesweeper board and generate the mines
-    //
-    void init()
+    // A new (or truncated) file gets a fresh zeroed header
+    if ((size_t) st.st_size < sizeof(SStatsHeader))
     {
-        // Initialize the state variables
-        done = false;
-        win = false;
-        lose = false;
-        revealCount = 0;
-        flagCount = 0;
+        SStatsHeader fresh;
+        bzero(&fresh, sizeof(fresh));
+        fresh.magic = STATS_MAGIC;
+        fresh.version = STATS_VERSION;
 
-        // Free/Allocate/Zero the memory of the mine board
-        if (board != NULL)
+        if (pwrite(statsFd, &fresh, sizeof(fresh), 0) !=
+            (ssize_t) sizeof(fresh))
         {
-            free(board);
+            close(statsFd);
+            statsFd = -1;
+            return false;
         }
+    }
 
-        board = (TCell *) malloc(sizeof(TCell) * width * height);
-        bzero(board, sizeof(TCell) * width * height);
+    void * map = mmap(NULL, sizeof(SStatsHeader), PROT_READ | PROT_WRITE,
+                      MAP_SHARED, statsFd, 0);
 
-        // Free/Allocate/Zero the memory of the player input board
-        if (input_board != NULL)
-        {
-            free(input_board);
-        }
+    if (map == MAP_FAILED)
+    {
+        close(statsFd);
+        statsFd = -1;
+        return false;
+    }
 
-        input_board = (TCell *) malloc(sizeof(TCell) * width * height);
-        bzero(input_board, sizeof(TCell) * width * height);
+    statsHeader = (SStatsHeader *) map;
 
-        // Add the mines
-        TCell minesAdded = 0;
-        while (minesAdded < mines)
-        {
-            TCell y = random(0, height);
-            TCell x = random(0, width);
+    if (statsHeader->magic != STATS_MAGIC ||
+        statsHeader->version != STATS_VERSION)
+    {
+        munmap(statsHeader, sizeof(SStatsHeader));
+        close(statsFd);
+        statsHeader = NULL;
+        statsFd = -1;
+        return false;
+    }
 
-            // Ensure we aren't placing a mine on a cell that already has one
-            if (get(y, x) == 0)
-            {
-                set(y, x, MINE);
-                ++minesAdded;
-            }
-        }
+    return true;
+}
 
-        // Calculate the number of neighboring mines for each cell
-        for (TCell h = 0 ; h < height ; ++h)
-        {
-            for (TCell w = 0 ; w < width ; ++w)
-            {
-                if (get(h, w) != MINE)
-                {
-                    set(h, w, count_neighbors(h, w) + '0');
-                }
-            }
-        }
+//
+// Append one finished-game record to the log and fold it into the
+// mapped aggregate header in place
+//
+void stats_record_game(const TIndex height, const TIndex width,
+                       const TIndex mines, const bool win,
+                       const uint64_t elapsed_ms,
+                       const TIndex revealCount, const TIndex flagCount)
+{
+    if (statsHeader == NULL)
+    {
+        return;
+    }
 
-        // Reset the start clock
-        clock_gettime(CLOCK_MONOTONIC_RAW, &startTime);
+    SStatsRecord record;
+    bzero(&record, sizeof(record));
+    record.height = height;
+    record.width = width;
+    record.mines = mines;
+    record.win = win ? 1 : 0;
+    record.elapsed_ms = elapsed_ms;
+    record.revealCount = revealCount;
+    record.flagCount = flagCount;
+
+    lseek(statsFd, 0, SEEK_END);
+
+    if (write(statsFd, &record, sizeof(record)) != (ssize_t) sizeof(record))
+    {
+        return;
     }
 
-    //
-    // Destructor. Free the memory.
-    //
-    ~SBoard()
+    statsHeader->games += 1;
+
+    if (win)
     {
-        if (board != NULL)
-        {
-            free(board);
-        }
+        statsHeader->wins += 1;
 
-        if (input_board != NULL)
+        if (statsHeader->best_win_ms == 0 ||
+            elapsed_ms < statsHeader->best_win_ms)
         {
-            free(input_board);
+            statsHeader->best_win_ms = elapsed_ms;
         }
     }
+    else
+    {
+        statsHeader->losses += 1;
+    }
 
-    //
-    // Gets the cell value of the mine board at index y,x
-    //
-    const TCell get(const TCell y, const TCell x) const
+    statsHeader->total_elapsed_ms += elapsed_ms;
+    statsHeader->total_revealed += (uint64_t) revealCount;
+    statsHeader->total_flagged += (uint64_t) flagCount;
+}
+
+//
+// Unmap the aggregate header and close the stats file
+//
+void stats_close()
+{
+    if (statsHeader != NULL)
     {
-        if (is_valid(y, x))
-        {
-            return board[x * height + y];
-        }
+        munmap(statsHeader, sizeof(SStatsHeader));
+        statsHeader = NULL;
+    }
 
-        return ERROR;
+    if (statsFd >= 0)
+    {
+        close(statsFd);
+        statsFd = -1;
     }
+}
 
-    //
-    // Sets the cell value of the mine board at index y,x
-    //
-    void set(const TCell y, const TCell x, const TCell val)
+//
+// Print the lifetime aggregates. Only the mapped header is read; the
+// record log is never walked, so this is O(1) in games played.
+//
+void stats_print()
+{
+    if (statsHeader == NULL)
     {
-        if (is_valid(y, x))
-        {
-            board[x * height + y] = val;
-        }
+        return;
     }
 
-    //
-    // Gets the cell value of the player input board at index y,x
-    //
-    TCell geti(const TCell y, const TCell x) const
+    printf("Games:          %lu\n", (unsigned long) statsHeader->games);
+    printf("Wins:           %lu\n", (unsigned long) statsHeader->wins);
+    printf("Losses:         %lu\n", (unsigned long) statsHeader->losses);
+
+    if (statsHeader->games > 0)
     {
-        if (is_valid(y, x))
-        {
-            return input_board[x * height + y];
-        }
+        printf("Win rate:       %.1f%%\n",
+               100.0 * (double) statsHeader->wins /
+               (double) statsHeader->games);
+        printf("Play time:      %.1f sec\n",
+               (double) statsHeader->total_elapsed_ms / 1000.0);
+        printf("Cells revealed: %lu\n",
+               (unsigned long) statsHeader->total_revealed);
+        printf("Flags placed:   %lu\n",
+               (unsigned long) statsHeader->total_flagged);
+    }
 
-        return ERROR;
+    if (statsHeader->best_win_ms != 0)
+    {
+        printf("Best win:       %.1f sec\n",
+               (double) statsHeader->best_win_ms / 1000.0);
     }
+}
 
-    //
-    // Sets the cell value of the player input board at index y,x
-    //
-    void seti(const TCell y, const TCell x, const TCell val)
+//
+// A solver constraint for one revealed numbered cell: its value, the
+// number of flagged neighbors, and the unrevealed unflagged neighbors it
+// constrains
+//
+struct SConstraint
+{
+    TIndex y;
+    TIndex x;
+    TCell value;
+    TCell flags;
+    TCell unknownCount;
+    TIndex unknownY[8];
+    TIndex unknownX[8];
+};
+
+//
+// Hot-path instrumentation, compiled in with `make prof` (-DMS_PROF)
+// and absent from the default build. Each site accumulates a histogram
+// of elapsed cycle counts in power-of-two buckets, dumped to stdout
+// once the curses session ends. Counters are bumped with atomic adds so
+// the headless worker threads can share them.
+//
+#ifdef MS_PROF
+
+enum EProfSite
+{
+    PROF_RESET = 0,
+    PROF_FLOOD,
+    PROF_UPDATE_FIELD,
+    PROF_UPDATE_SCORE,
+    PROF_LOOP,
+    PROF_SITE_COUNT
+};
+
+static const int PROF_BUCKETS = 40;
+
+struct SProfSite
+{
+    const char * name;
+    uint64_t count;
+    uint64_t total;
+    uint64_t buckets[PROF_BUCKETS];
+};
+
+static SProfSite profSites[PROF_SITE_COUNT] =
+{
+    { "reset",        0, 0, { 0 } },
+    { "flood_reveal", 0, 0, { 0 } },
+    { "update_field", 0, 0, { 0 } },
+    { "update_score", 0, 0, { 0 } },
+    { "loop_iter",    0, 0, { 0 } },
+};
+
+//
+// Timestamp counter: raw TSC cycles on x86, nanoseconds elsewhere
+//
+static inline uint64_t prof_now()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+//
+// Record one timed interval into a site's log2-bucketed histogram
+//
+static void prof_add(const int site, const uint64_t cycles)
+{
+    SProfSite & p = profSites[site];
+
+    int bucket = (cycles < 2) ? 0 : (63 - __builtin_clzll(cycles));
+
+    if (bucket > PROF_BUCKETS - 1)
     {
-        if (is_valid(y, x))
-        {
-            input_board[x * height + y] = val;
-        }
+        bucket = PROF_BUCKETS - 1;
     }
 
-    //
-    // Reveals the cell at the current cursor position
-    //
-    void reveal()
+    __sync_fetch_and_add(&p.count, 1);
+    __sync_fetch_and_add(&p.total, cycles);
+    __sync_fetch_and_add(&p.buckets[bucket], 1);
+}
+
+//
+// Print every populated histogram. Called after endwin(), so the dump
+// lands on the restored terminal.
+//
+void prof_dump()
+{
+    for (int site = 0 ; site < PROF_SITE_COUNT ; ++site)
     {
-        // If this is the first reveal, make sure it is not a mine.
-        while (revealCount == 0 && get(curY, curX) == MINE)
-        {
-            init();
-        }
+        const SProfSite & p = profSites[site];
 
-        // Reset the starting timer upon the first successful cell reveal
-        if (revealCount == 0)
+        if (p.count == 0)
         {
-            clock_gettime(CLOCK_MONOTONIC_RAW, &startTime);
+            continue;
         }
 
-        // Call recursive reveal (to handle auto-reveal cells that
-        // have zero neighboring mines.
-        r_reveal(curY, curX);
-    }
+        printf("%-14s calls %-10lu mean %lu cycles\n",
+               p.name, (unsigned long) p.count,
+               (unsigned long) (p.total / p.count));
 
-    //
-    // Recursive reveal the cell at y,x and neighboring cells with zero mines
-    //
-    void r_reveal(const TCell y, const TCell x)
-    {
-        // No need to recurse if the game is done
-        if (!is_done())
+        uint64_t peak = 0;
+
+        for (int b = 0 ; b < PROF_BUCKETS ; ++b)
         {
-            // Don't recursively look at cells that are flagged
-            if (geti(y, x) == FLAGGED)
+            if (p.buckets[b] > peak)
             {
-                return;
+                peak = p.buckets[b];
             }
+        }
 
-            // Reveal the cell
-            if (geti(y, x) != REVEAL)
+        for (int b = 0 ; b < PROF_BUCKETS ; ++b)
+        {
+            if (p.buckets[b] == 0)
             {
-                seti(y, x, REVEAL);
-                ++revealCount;
+                continue;
             }
 
-            // Check if the player hit a mine
-            if (get(y, x) == MINE)
-            {
-                win = false;
-                lose = true;
-                done = true;
+            printf("  2^%-3d %10lu ", b, (unsigned long) p.buckets[b]);
 
-                return;
-            }
+            const int bar = (int) ((p.buckets[b] * 40) / peak);
 
-            // Check if the player revealed all cells successfully
-            if (revealCount >= max_reveal())
+            for (int i = 0 ; i < bar ; ++i)
             {
-                win = true;
-                lose = false;
-                done = true;
-                return;
+                putchar('#');
             }
 
-            // Check if needing to recurse for cells with zero neighboring
-            // mines
-            if (get(y, x) == '0')
-            {
-                for (TCell h = y-1 ; h <= y+1 ; ++h)
-                    for (TCell w = x-1 ; w <= x+1 ; ++w)
-                        if (is_valid(h, w) && !(h==y && w==x) && (geti(h, w) != REVEAL))
-                            r_reveal(h, w);
-            }
+            putchar('\n');
         }
     }
+}
 
-    //
-    // Returns the number of cells that must be successfully revealed in order
-    // to win the game
-    //
-    TCell max_reveal() const
+#define PROF_START(v) const uint64_t v = prof_now()
+#define PROF_STOP(site, v) prof_add(site, prof_now() - (v))
+
+#else // MS_PROF
+
+void prof_dump() {}
+
+#define PROF_START(v)
+#define PROF_STOP(site, v)
+
+#endif // MS_PROF
+
+//
+// Vectorized kernels for the neighbor-count sweep: sum three byte rows
+// into a destination row. The widest variant the CPU supports is
+// selected once at startup by select_kernels(), with a portable scalar
+// fallback.
+//
+typedef void (*TRowAdd3)(uint8_t * dst, const uint8_t * a,
+                         const uint8_t * b, const uint8_t * c,
+                         const TIndex n);
+
+static void row_add3_scalar(uint8_t * dst, const uint8_t * a,
+                            const uint8_t * b, const uint8_t * c,
+                            const TIndex n)
+{
+    for (TIndex i = 0 ; i < n ; ++i)
     {
-        return ((height * width) - mines);
+        dst[i] = a[i] + b[i] + c[i];
     }
+}
 
-    //
-    // Toggle the flag on the cell at the current cursor position
-    //
-    void flag()
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("sse2")))
+static void row_add3_sse2(uint8_t * dst, const uint8_t * a,
+                          const uint8_t * b, const uint8_t * c,
+                          const TIndex n)
+{
+    TIndex i = 0;
+
+    for ( ; i + 16 <= n ; i += 16)
     {
-        if (geti(curY, curX) == BLANK)
-        {
-            // Toggle flag on
-            seti(curY, curX, FLAGGED);
-            ++flagCount;
+        const __m128i va = _mm_loadu_si128((const __m128i *) (a + i));
+        const __m128i vb = _mm_loadu_si128((const __m128i *) (b + i));
+        const __m128i vc = _mm_loadu_si128((const __m128i *) (c + i));
+
+        _mm_storeu_si128((__m128i *) (dst + i),
+                         _mm_add_epi8(_mm_add_epi8(va, vb), vc));
+    }
+
+    for ( ; i < n ; ++i)
+    {
+        dst[i] = a[i] + b[i] + c[i];
+    }
+}
+
+__attribute__((target("avx2")))
+static void row_add3_avx2(uint8_t * dst, const uint8_t * a,
+                          const uint8_t * b, const uint8_t * c,
+                          const TIndex n)
+{
+    TIndex i = 0;
+
+    for ( ; i + 32 <= n ; i += 32)
+    {
+        const __m256i va = _mm256_loadu_si256((const __m256i *) (a + i));
+        const __m256i vb = _mm256_loadu_si256((const __m256i *) (b + i));
+        const __m256i vc = _mm256_loadu_si256((const __m256i *) (c + i));
+
+        _mm256_storeu_si256((__m256i *) (dst + i),
+                            _mm256_add_epi8(_mm256_add_epi8(va, vb), vc));
+    }
+
+    for ( ; i < n ; ++i)
+    {
+        dst[i] = a[i] + b[i] + c[i];
+    }
+}
+
+#endif
+
+static TRowAdd3 rowAdd3 = row_add3_scalar;
+
+//
+// Pick the widest row-add kernel the CPU supports
+//
+void select_kernels()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2"))
+    {
+        rowAdd3 = row_add3_avx2;
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        rowAdd3 = row_add3_sse2;
+    }
+#endif
+}
+
+//
+// Structure to represent the minesweeper grid of cells, and their state
+//
+template <TIndex CH = 0, TIndex CW = 0, TIndex CM = 0>
+struct TBoard
+{
+private:
+
+    // Current cursor position
+    TIndex curY;
+    TIndex curX;
+
+    // Visible viewport: origin and size of the board rectangle shown in
+    // the field window. Boards larger than the window scroll the origin
+    // to follow the cursor; rendering cost scales with the viewport, not
+    // the board.
+    TIndex viewY = 0;
+    TIndex viewX = 0;
+    TIndex viewHeight = 0;
+    TIndex viewWidth = 0;
+
+    // Game state
+    bool done;
+    bool win;
+    bool lose;
+
+    // Whether the end-of-game mine overlay has been composed into the
+    // frame buffer, so repaints after a loss stop re-walking the mine
+    // and flag bitsets
+    bool loseComposed = false;
+    TIndex revealCount;
+    TIndex flagCount;
+
+    // Board dimensions. The template parameters pin them at compile
+    // time for the specialized preset variants (zero means runtime
+    // sized); dim_h/dim_w/dim_m fold to constants there, so indexing
+    // strides and loop bounds become compile-time constants.
+    const TIndex height;
+    const TIndex width;
+    const TIndex mines;
+
+    TIndex dim_h() const
+    {
+        return (CH != 0) ? CH : height;
+    }
+
+    TIndex dim_w() const
+    {
+        return (CW != 0) ? CW : width;
+    }
+
+    TIndex dim_m() const
+    {
+        return (CM != 0) ? CM : mines;
+    }
+
+    // Cell states, one interleaved array holding both the mine values
+    // and the player input states
+    SCell * cells = NULL;
+
+    // Defer screen refreshes to an external doupdate(): the repaint
+    // routines stage changes with wnoutrefresh() instead of flushing
+    // each window separately, so multi-board sessions batch all their
+    // window updates into one terminal write.
+    bool deferRefresh = false;
+
+    // Cells changed since the last redraw, as linear board indices.
+    // When the list would overflow (or the whole board changed), the
+    // allDirty flag forces one full redraw instead.
+    TIndex * dirtyList = NULL;
+    TIndex dirtyCount = 0;
+    bool allDirty = true;
+
+    // Scratch buffers for mine placement and the flood-fill worklist
+    TIndex * order = NULL;
+    TIndex * workY = NULL;
+    TIndex * workX = NULL;
+
+    // Word-packed bitsets over the cells, kept in sync by set/seti, so
+    // full-board queries scan 64 cells per machine word
+    uint64_t * revealedBits = NULL;
+    uint64_t * flaggedBits = NULL;
+    uint64_t * mineBits = NULL;
+
+    // The solver frontier: unrevealed unflagged cells adjacent to a
+    // revealed cell, maintained incrementally by seti
+    uint64_t * frontierBits = NULL;
+
+    // Scratch for the vectorized neighbor-count sweep: a 0/1 byte per
+    // cell expanded from the mine bitset, the per-cell vertical sums,
+    // and two row-sized rows (horizontal sums and a zero edge row)
+    uint8_t * mineMask = NULL;
+    uint8_t * vertSum = NULL;
+    uint8_t * rowScratch = NULL;
+
+    // Off-screen frame buffers: character in the low byte, color pair in
+    // the high byte. Frames are composed into frameBuf, diffed against
+    // the previously presented shownBuf, and only changed runs are
+    // flushed to ncurses.
+    uint16_t * frameBuf = NULL;
+    uint16_t * shownBuf = NULL;
+
+    // The single backing block all of the above is carved from, and
+    // whether this board owns it (false when it came from a caller's
+    // arena, in which case the destructor never touches the heap)
+    void * backing = NULL;
+    bool ownsMemory = true;
+
+    // Timestamp when the game is started
+    struct timespec startTime;
+
+    // Handles to the ncurses windows
+    WINDOW * pScore;
+    WINDOW * pField;
+
+    // Unused default constructor
+    TBoard() : height(0), width(0), mines(0) {}
+
+public:
+
+    //
+    // Constructor for the minesweeper board
+    //
+    TBoard( const TIndex height,
+            const TIndex width,
+            const TIndex mines,
+            WINDOW * const pScoreWin,
+            WINDOW * const pFieldWin)
+    : height(height), width(width), mines(mines), pScore(pScoreWin), pField(pFieldWin)
+    {
+        curY = 0;
+        curX = 0;
+
+        // All board storage is sized once here; reset() never touches
+        // the heap. valid_geometry() bounds the cell count but not the
+        // arena the dimensions imply, so a refused allocation exits
+        // with a diagnostic instead of crashing in carve().
+        void * const arena = malloc(arena_size(dim_h(), dim_w()));
+
+        if (arena == NULL)
+        {
+            fprintf(stderr, "minesweeper: cannot allocate a %dx%d board\n",
+                    dim_h(), dim_w());
+            exit(EXIT_FAILURE);
         }
-        else if (geti(curY, curX) == FLAGGED)
+
+        carve(arena);
+
+        init_viewport();
+        reset();
+    }
+
+    //
+    // Constructor carving all board storage out of a caller-owned arena
+    // of at least arena_size(height, width) bytes. Used by the batch
+    // simulation workers.
+    //
+    TBoard( const TIndex height,
+            const TIndex width,
+            const TIndex mines,
+            WINDOW * const pScoreWin,
+            WINDOW * const pFieldWin,
+            void * const arena)
+    : height(height), width(width), mines(mines), pScore(pScoreWin), pField(pFieldWin)
+    {
+        curY = 0;
+        curX = 0;
+        ownsMemory = false;
+
+        carve(arena);
+
+        init_viewport();
+        reset();
+    }
+
+    //
+    // Lay out all the board storage inside one backing block. The
+    // bitsets come first to keep their 8-byte alignment, followed by the
+    // index arrays and the cell array.
+    //
+    void carve(void * const block)
+    {
+        const TIndex total = dim_w() * dim_h();
+        char * p = (char *) block;
+
+        backing = block;
+
+        revealedBits = (uint64_t *) p;
+        p += sizeof(uint64_t) * bit_words();
+        flaggedBits = (uint64_t *) p;
+        p += sizeof(uint64_t) * bit_words();
+        mineBits = (uint64_t *) p;
+        p += sizeof(uint64_t) * bit_words();
+        frontierBits = (uint64_t *) p;
+        p += sizeof(uint64_t) * bit_words();
+        dirtyList = (TIndex *) p;
+        p += sizeof(TIndex) * total;
+        order = (TIndex *) p;
+        p += sizeof(TIndex) * total;
+        workY = (TIndex *) p;
+        p += sizeof(TIndex) * total;
+        workX = (TIndex *) p;
+        p += sizeof(TIndex) * total;
+        frameBuf = (uint16_t *) p;
+        p += sizeof(uint16_t) * total;
+        shownBuf = (uint16_t *) p;
+        p += sizeof(uint16_t) * total;
+        cells = (SCell *) p;
+        p += sizeof(SCell) * total;
+        mineMask = (uint8_t *) p;
+        p += total;
+        vertSum = (uint8_t *) p;
+        p += total;
+        rowScratch = (uint8_t *) p;
+    }
+
+    //
+    // Returns the number of arena bytes needed to hold all the storage
+    // for a board of the given dimensions
+    //
+    static size_t arena_size(const TIndex height, const TIndex width)
+    {
+        const size_t total = (size_t) width * (size_t) height;
+        const size_t words = (total + 63) / 64;
+
+        return (sizeof(SCell) * total) + (4 * sizeof(TIndex) * total) +
+               (4 * sizeof(uint64_t) * words) + (2 * sizeof(uint16_t) * total) +
+               (2 * total) + (2 * (size_t) width);
+    }
+
+    //
+    // Reset the minesweeper board for a new game and generate the mines.
+    // Performs no heap allocation: the backing block was sized by the
+    // constructor, so a reset only re-zeroes it and re-places the mines.
+    //
+    void reset()
+    {
+        PROF_START(profT);
+
+        // Initialize the state variables
+        done = false;
+        win = false;
+        lose = false;
+        loseComposed = false;
+        revealCount = 0;
+        flagCount = 0;
+
+        // Zero the bitsets and the cell array. The bitsets sit at the
+        // front of the backing block, so they clear as one memset.
+        bzero(revealedBits, 4 * sizeof(uint64_t) * bit_words());
+        bzero(cells, sizeof(SCell) * dim_w() * dim_h());
+
+        // Poison the presented frame so the next present() emits every
+        // cell of the new board
+        memset(shownBuf, 0xFF, sizeof(uint16_t) * dim_w() * dim_h());
+
+        // Force a full redraw of the freshly generated board
+        dirtyCount = 0;
+        allDirty = true;
+
+        // Add the mines with a partial Fisher-Yates shuffle over the cell
+        // indices, so placing M mines costs exactly M swaps with no
+        // rejection sampling, regardless of mine density
+        const TIndex total = dim_w() * dim_h();
+
+        for (TIndex i = 0 ; i < total ; ++i)
         {
-            // Toggle flag off
-            seti(curY, curX, BLANK);
-            --flagCount;
+            order[i] = i;
+        }
+
+        for (TIndex m = 0 ; m < dim_m() && m < total ; ++m)
+        {
+            const TIndex j = random(m, total);
+
+            const TIndex tmp = order[m];
+            order[m] = order[j];
+            order[j] = tmp;
+
+            set(order[m] / dim_w(), order[m] % dim_w(), MINE);
         }
+
+        // Calculate the number of neighboring mines for each cell
+        count_all_neighbors();
+
+        // Reset the start clock
+        clock_gettime(CLOCK_MONOTONIC_RAW, &startTime);
+
+        PROF_STOP(PROF_RESET, profT);
     }
 
     //
-    // Count the number of neighboring cells that have a mine
+    // Swap in a backing arena prepared by the board generator service:
+    // a fully reset same-geometry board built off the main thread, so a
+    // new game costs a pointer swap instead of mine placement and a
+    // neighbor-count sweep. Returns the old backing block so the caller
+    // can hand it back to the generator for reuse.
     //
-    TCell count_neighbors(const TCell y, const TCell x) const
+    void * adopt_backing(void * const prepared)
     {
-        TCell count = 0;
+        void * const old = backing;
 
-        for (TCell h = y-1 ; h <= y+1 ; ++h)
-            for (TCell w = x-1 ; w <= x+1 ; ++w)
-                if (is_valid(h, w) && !(h==y && w==x))
-                    if (get(h, w) == MINE)
-                        ++count;
+        carve(prepared);
 
-        return count;
+        // The prepared arena already holds zeroed session state, placed
+        // mines, counted neighbors, and a poisoned shown frame; only the
+        // per-game scalars live outside the arena
+        done = false;
+        win = false;
+        lose = false;
+        loseComposed = false;
+        revealCount = 0;
+        flagCount = 0;
+        dirtyCount = 0;
+        allDirty = true;
+
+        clock_gettime(CLOCK_MONOTONIC_RAW, &startTime);
+
+        return old;
     }
 
-    // 
-    // Check if the cell location at y,x is in the valid range
     //
-    bool is_valid(const TCell y, const TCell x) const
+    // Destructor. Free the backing block if this board owns it.
+    //
+    ~TBoard()
     {
-        return (y >= 0 && y < height && x >= 0 && x < width);
+        if (ownsMemory && backing != NULL)
+        {
+            free(backing);
+        }
     }
 
     //
-    // Quit the game
+    // Number of 64-bit words in each cell bitset
     //
-    void quit()
+    TIndex bit_words() const
     {
-        done = true;
+        return ((dim_w() * dim_h()) + 63) / 64;
     }
 
     //
-    // Check if the game is done
+    // Single-bit helpers for the cell bitsets
     //
-    bool is_done() const
+    static void bit_set(uint64_t * const bits, const TIndex idx)
     {
-        return done;
+        bits[idx / 64] |= (1ULL << (idx % 64));
+    }
+
+    static void bit_clear(uint64_t * const bits, const TIndex idx)
+    {
+        bits[idx / 64] &= ~(1ULL << (idx % 64));
+    }
+
+    static bool bit_test(const uint64_t * const bits, const TIndex idx)
+    {
+        return (bits[idx / 64] >> (idx % 64)) & 1;
     }
 
     //
-    // Move the cursor dy in the y direction and dx in the x direction
+    // Mark the cell at y,x as needing a redraw
     //
-    void move_cur(const TCell dy, const TCell dx)
+    void mark_dirty(const TIndex y, const TIndex x)
     {
-        TCell newY = dy + curY;
-        TCell newX = dx + curX;
+        if (allDirty)
+        {
+            return;
+        }
 
-        if (is_valid(newY, newX))
+        if (dirtyCount >= dim_w() * dim_h())
         {
-            curY = newY;
-            curX = newX;
+            // The list is full; fall back to a full redraw
+            allDirty = true;
+            return;
         }
+
+        dirtyList[dirtyCount] = y * dim_w() + x;
+        ++dirtyCount;
     }
 
     //
-    // Update the score window and the mine field window
+    // Gets the cell value of the mine board at index y,x
     //
-    void update()
+    const TCell get(const TIndex y, const TIndex x) const
     {
-        update_score();
-        update_field();
+        if (is_valid(y, x))
+        {
+            return cells[y * dim_w() + x].val;
+        }
+
+        return ERROR;
     }
 
-    // Update the mine field window view
     //
-    void update_field()
+    // Sets the cell value of the mine board at index y,x
+    //
+    void set(const TIndex y, const TIndex x, const TCell val)
+    {
+        if (is_valid(y, x))
+        {
+            if (cells[y * dim_w() + x].val != val)
+            {
+                cells[y * dim_w() + x].val = val;
+                mark_dirty(y, x);
+
+                // Keep the mine bitset in sync
+                if (val == MINE)
+                {
+                    bit_set(mineBits, y * dim_w() + x);
+                }
+                else
+                {
+                    bit_clear(mineBits, y * dim_w() + x);
+                }
+            }
+        }
+    }
+
+    //
+    // Gets the cell value of the player input board at index y,x
+    //
+    TCell geti(const TIndex y, const TIndex x) const
+    {
+        if (is_valid(y, x))
+        {
+            return cells[y * dim_w() + x].input;
+        }
+
+        return ERROR;
+    }
+
+    //
+    // Sets the cell value of the player input board at index y,x
+    //
+    void seti(const TIndex y, const TIndex x, const TCell val)
+    {
+        if (is_valid(y, x))
+        {
+            if (cells[y * dim_w() + x].input != val)
+            {
+                cells[y * dim_w() + x].input = val;
+                mark_dirty(y, x);
+
+                // Keep the revealed/flagged bitsets and the frontier
+                // in sync
+                const TIndex idx = y * dim_w() + x;
+
+                if (val == REVEAL)
+                {
+                    bit_set(revealedBits, idx);
+
+                    // The cell leaves the frontier; its unrevealed
+                    // unflagged neighbors join it
+                    bit_clear(frontierBits, idx);
+
+                    for (TIndex h = y-1 ; h <= y+1 ; ++h)
+                    {
+                        for (TIndex w = x-1 ; w <= x+1 ; ++w)
+                        {
+                            if (is_valid(h, w) && !(h == y && w == x))
+                            {
+                                const TIndex n = h * dim_w() + w;
+
+                                if (!bit_test(revealedBits, n) &&
+                                    !bit_test(flaggedBits, n))
+                                {
+                                    bit_set(frontierBits, n);
+                                }
+                            }
+                        }
+                    }
+                }
+                else if (val == FLAGGED)
+                {
+                    bit_set(flaggedBits, idx);
+                    bit_clear(frontierBits, idx);
+                }
+                else
+                {
+                    bit_clear(revealedBits, idx);
+                    bit_clear(flaggedBits, idx);
+
+                    // An unflagged cell rejoins the frontier if it still
+                    // touches a revealed cell
+                    if (has_revealed_neighbor(y, x))
+                    {
+                        bit_set(frontierBits, idx);
+                    }
+                }
+            }
+        }
+    }
+
+    //
+    // Returns a pointer to the first cell of row y, so bulk passes can
+    // walk a row with a bumped pointer instead of a bounds-checked
+    // get(y, x) call per cell
+    //
+    SCell * row(const TIndex y)
+    {
+        return cells + (y * dim_w());
+    }
+
+    const SCell * row(const TIndex y) const
     {
-        // Iterate through all the cells in the mine field
-        for (TCell y = 0 ; y < height ; ++y)
+        return cells + (y * dim_w());
+    }
+
+    //
+    // Find the linear index of the first unrevealed cell at or after the
+    // linear index 'from', scanning 64 cells per machine word. Returns
+    // ERROR when every cell from 'from' onward is revealed.
+    //
+    TIndex next_unrevealed(const TIndex from) const
+    {
+        const TIndex total = dim_w() * dim_h();
+
+        if (from < 0 || from >= total)
+        {
+            return (TIndex) ERROR;
+        }
+
+        TIndex word = from / 64;
+        uint64_t bits = ~revealedBits[word] & (~0ULL << (from % 64));
+
+        while (true)
+        {
+            if (bits != 0)
+            {
+                const TIndex idx = (word * 64) + __builtin_ctzll(bits);
+                return (idx < total) ? idx : (TIndex) ERROR;
+            }
+
+            ++word;
+
+            if (word >= bit_words())
+            {
+                return (TIndex) ERROR;
+            }
+
+            bits = ~revealedBits[word];
+        }
+    }
+
+    //
+    // Check whether any neighbor of the cell at y,x is revealed
+    //
+    bool has_revealed_neighbor(const TIndex y, const TIndex x) const
+    {
+        for (TIndex h = y-1 ; h <= y+1 ; ++h)
+            for (TIndex w = x-1 ; w <= x+1 ; ++w)
+                if (is_valid(h, w) && !(h == y && w == x))
+                    if (bit_test(revealedBits, h * dim_w() + w))
+                        return true;
+
+        return false;
+    }
+
+    //
+    // Number of cells currently on the solver frontier
+    //
+    TIndex frontier_size() const
+    {
+        TIndex count = 0;
+
+        for (TIndex i = 0 ; i < bit_words() ; ++i)
+        {
+            count += __builtin_popcountll(frontierBits[i]);
+        }
+
+        return count;
+    }
+
+    //
+    // Find the linear index of the first frontier cell at or after the
+    // linear index 'from'. Returns ERROR when there is none.
+    //
+    TIndex next_frontier(const TIndex from) const
+    {
+        const TIndex total = dim_w() * dim_h();
+
+        if (from < 0 || from >= total)
+        {
+            return (TIndex) ERROR;
+        }
+
+        TIndex word = from / 64;
+        uint64_t bits = frontierBits[word] & (~0ULL << (from % 64));
+
+        while (true)
+        {
+            if (bits != 0)
+            {
+                return (word * 64) + __builtin_ctzll(bits);
+            }
+
+            ++word;
+
+            if (word >= bit_words())
+            {
+                return (TIndex) ERROR;
+            }
+
+            bits = frontierBits[word];
+        }
+    }
+
+    //
+    // Build the solver constraint for the revealed numbered cell at y,x:
+    // its value, flagged-neighbor count, and the unrevealed unflagged
+    // neighbors it constrains. The neighborhood bounds are clamped once
+    // up front, so no per-cell bounds checks are needed. Returns false
+    // if the cell does not yield a constraint.
+    //
+    bool get_constraint(const TIndex y, const TIndex x,
+                        SConstraint & out) const
+    {
+        if (!is_valid(y, x) || !bit_test(revealedBits, y * dim_w() + x))
+        {
+            return false;
+        }
+
+        out.y = y;
+        out.x = x;
+        out.value = cells[y * dim_w() + x].val;
+        out.flags = 0;
+        out.unknownCount = 0;
+
+        if (out.value < '0' || out.value > '8')
+        {
+            return false;
+        }
+
+        const TIndex y0 = (y > 0) ? y-1 : y;
+        const TIndex y1 = (y < dim_h()-1) ? y+1 : y;
+        const TIndex x0 = (x > 0) ? x-1 : x;
+        const TIndex x1 = (x < dim_w()-1) ? x+1 : x;
+
+        for (TIndex h = y0 ; h <= y1 ; ++h)
+        {
+            const SCell * r = row(h);
+
+            for (TIndex w = x0 ; w <= x1 ; ++w)
+            {
+                if (h == y && w == x)
+                {
+                    continue;
+                }
+
+                if (r[w].input == FLAGGED)
+                {
+                    ++out.flags;
+                }
+                else if (r[w].input != REVEAL)
+                {
+                    out.unknownY[(int) out.unknownCount] = h;
+                    out.unknownX[(int) out.unknownCount] = w;
+                    ++out.unknownCount;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    //
+    // Count the unrevealed cells on the board with one popcount per 64
+    // cells
+    //
+    TIndex count_unrevealed() const
+    {
+        TIndex revealed = 0;
+
+        for (TIndex i = 0 ; i < bit_words() ; ++i)
+        {
+            revealed += __builtin_popcountll(revealedBits[i]);
+        }
+
+        return (dim_w() * dim_h()) - revealed;
+    }
+
+    //
+    // Reveals the cell at the current cursor position. Returns the number
+    // of cells that were revealed.
+    //
+    TIndex reveal()
+    {
+        // If this is the first reveal, make sure it is not a mine by
+        // relocating the offending mine instead of regenerating the board
+        if (revealCount == 0 && get(curY, curX) == MINE)
+        {
+            relocate_mine(curY, curX);
+        }
+
+        // Reset the starting timer upon the first successful cell reveal
+        if (revealCount == 0)
+        {
+            clock_gettime(CLOCK_MONOTONIC_RAW, &startTime);
+        }
+
+        // Call the flood-fill reveal engine (to handle auto-reveal of
+        // cells that have zero neighboring mines)
+        return flood_reveal(curY, curX);
+    }
+
+    //
+    // Move the mine at y,x to the first mine-free cell on the board, and
+    // incrementally patch the neighbor counts around the two affected
+    // cells. Used for first-click safety, so a first reveal on a mine
+    // costs O(1) instead of regenerating and recounting the whole board.
+    //
+    void relocate_mine(const TIndex y, const TIndex x)
+    {
+        if (get(y, x) != MINE)
+        {
+            return;
+        }
+
+        // Find the first cell that does not already hold a mine
+        TIndex newY = (TIndex) ERROR;
+        TIndex newX = (TIndex) ERROR;
+
+        for (TIndex h = 0 ; h < dim_h() && newY == (TIndex) ERROR ; ++h)
+        {
+            const SCell * r = row(h);
+
+            for (TIndex w = 0 ; w < dim_w() ; ++w)
+            {
+                if (r[w].val != MINE)
+                {
+                    newY = h;
+                    newX = w;
+                    break;
+                }
+            }
+        }
+
+        // No free cell exists (the board is all mines); nothing to do
+        if (newY == (TIndex) ERROR)
+        {
+            return;
+        }
+
+        // Move the mine: clear the source cell first (which also drops
+        // its mineBits bit), then recount the two affected 3x3
+        // neighborhoods. The source cell picks up its own count as the
+        // center of the first neighborhood, now that it is not a mine.
+        set(y, x, BLANK);
+        set(newY, newX, MINE);
+        patch_neighbors(y, x);
+        patch_neighbors(newY, newX);
+    }
+
+    //
+    // Recompute the neighbor counts of every non-mine cell in the 3x3
+    // neighborhood centered on y,x (including the center itself)
+    //
+    void patch_neighbors(const TIndex y, const TIndex x)
+    {
+        for (TIndex h = y-1 ; h <= y+1 ; ++h)
+            for (TIndex w = x-1 ; w <= x+1 ; ++w)
+                if (is_valid(h, w) && get(h, w) != MINE)
+                    set(h, w, count_neighbors(h, w) + '0');
+    }
+
+    //
+    // Reveal the cell at y,x if it is unrevealed and not flagged.
+    // Returns true if the cell was revealed by this call.
+    //
+    bool mark_reveal(const TIndex y, const TIndex x)
+    {
+        const TCell ival = geti(y, x);
+
+        if (ival != REVEAL && ival != FLAGGED && ival != ERROR)
+        {
+            seti(y, x, REVEAL);
+            ++revealCount;
+            return true;
+        }
+
+        return false;
+    }
+
+    //
+    // Flood-fill reveal of the cell at y,x and neighboring cells with zero
+    // mines. Uses an explicit worklist with scanline-style expansion of
+    // zero-cell runs, instead of one recursive call per neighboring cell.
+    // Returns the number of cells revealed.
+    //
+    TIndex flood_reveal(const TIndex y, const TIndex x)
+    {
+        PROF_START(profT);
+        const TIndex revealed = flood_reveal_work(y, x);
+        PROF_STOP(PROF_FLOOD, profT);
+
+        return revealed;
+    }
+
+    //
+    // The flood-fill worker behind flood_reveal(), kept separate so the
+    // timing wrapper covers its early exits
+    //
+    TIndex flood_reveal_work(const TIndex y, const TIndex x)
+    {
+        TIndex revealed = 0;
+
+        // No need to reveal if the game is done
+        if (is_done())
+        {
+            return revealed;
+        }
+
+        // Reveal the targeted cell
+        if (!mark_reveal(y, x))
+        {
+            return revealed;
+        }
+
+        ++revealed;
+
+        // Check if the player hit a mine
+        if (get(y, x) == MINE)
+        {
+            win = false;
+            lose = true;
+            done = true;
+
+            return revealed;
+        }
+
+        // Worklist of revealed zero-cells whose neighbors still need to be
+        // expanded. Cells are revealed before being pushed, so each cell
+        // can be pushed at most once and width*height entries suffice.
+        TIndex workSize = 0;
+
+        if (get(y, x) == '0')
+        {
+            workY[workSize] = y;
+            workX[workSize] = x;
+            ++workSize;
+        }
+
+        while (workSize > 0)
+        {
+            --workSize;
+            const TIndex py = workY[workSize];
+            const TIndex px = workX[workSize];
+
+            // Expand the contiguous run of zero-cells on this row
+            TIndex x0 = px;
+            while (is_valid(py, x0-1) && get(py, x0-1) == '0' &&
+                   mark_reveal(py, x0-1))
+            {
+                --x0;
+                ++revealed;
+            }
+
+            TIndex x1 = px;
+            while (is_valid(py, x1+1) && get(py, x1+1) == '0' &&
+                   mark_reveal(py, x1+1))
+            {
+                ++x1;
+                ++revealed;
+            }
+
+            // Reveal the cells bordering the run. Zero-cells in the rows
+            // above and below become new worklist entries.
+            for (TIndex h = py-1 ; h <= py+1 ; ++h)
+            {
+                for (TIndex w = x0-1 ; w <= x1+1 ; ++w)
+                {
+                    if (is_valid(h, w) && !(h == py && w >= x0 && w <= x1))
+                    {
+                        if (mark_reveal(h, w))
+                        {
+                            ++revealed;
+
+                            if (get(h, w) == '0')
+                            {
+                                workY[workSize] = h;
+                                workX[workSize] = w;
+                                ++workSize;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // Check if the player revealed all cells successfully
+        if (revealCount >= max_reveal())
+        {
+            win = true;
+            lose = false;
+            done = true;
+        }
+
+        return revealed;
+    }
+
+    //
+    // Milliseconds elapsed since the game started (zero until the first
+    // reveal)
+    //
+    uint64_t elapsed_ms() const
+    {
+        if (revealCount == 0)
+        {
+            return 0;
+        }
+
+        struct timespec curTime;
+        clock_gettime(CLOCK_MONOTONIC_RAW, &curTime);
+
+        return ((curTime.tv_sec - startTime.tv_sec) * 1000000 +
+                (curTime.tv_nsec - startTime.tv_nsec) / 1000) / 1000;
+    }
+
+    //
+    // Save the complete game state to the given path: one header, then
+    // the bitset and cell regions of the backing block written as-is.
+    // Returns true on success.
+    //
+    bool save_snapshot(const char * const path) const
+    {
+        FILE * f = fopen(path, "wb");
+
+        if (f == NULL)
+        {
+            return false;
+        }
+
+        SSnapshotHeader header;
+        header.magic = SNAPSHOT_MAGIC;
+        header.version = SNAPSHOT_VERSION;
+        header.height = dim_h();
+        header.width = dim_w();
+        header.mines = dim_m();
+        header.curY = curY;
+        header.curX = curX;
+        header.revealCount = revealCount;
+        header.flagCount = flagCount;
+        header.done = done;
+        header.win = win;
+        header.lose = lose;
+        header.pad = 0;
+        header.elapsed_ms = elapsed_ms();
+
+        bool ok = (fwrite(&header, sizeof(header), 1, f) == 1);
+        ok = ok && (fwrite(revealedBits, 4 * sizeof(uint64_t) * bit_words(),
+                           1, f) == 1);
+        ok = ok && (fwrite(cells, sizeof(SCell) * dim_w() * dim_h(), 1, f) == 1);
+
+        fclose(f);
+
+        return ok;
+    }
+
+    //
+    // Restore the game state from an already-validated snapshot header
+    // and the file positioned just past it. The bitset and cell regions
+    // are read straight into the backing block. Returns true on success.
+    //
+    bool restore_snapshot(const SSnapshotHeader & header, FILE * const f)
+    {
+        if (header.height != dim_h() || header.width != dim_w() ||
+            header.mines != dim_m())
+        {
+            return false;
+        }
+
+        if (fread(revealedBits, 4 * sizeof(uint64_t) * bit_words(),
+                  1, f) != 1)
+        {
+            return false;
+        }
+
+        if (fread(cells, sizeof(SCell) * dim_w() * dim_h(), 1, f) != 1)
+        {
+            return false;
+        }
+
+        curY = header.curY;
+        curX = header.curX;
+        revealCount = header.revealCount;
+        flagCount = header.flagCount;
+        done = header.done;
+        win = header.win;
+        lose = header.lose;
+
+        // Rewind the start clock so the restored elapsed time continues
+        clock_gettime(CLOCK_MONOTONIC_RAW, &startTime);
+        startTime.tv_sec -= (time_t) (header.elapsed_ms / 1000);
+        startTime.tv_nsec -= (long) ((header.elapsed_ms % 1000) * 1000000);
+
+        // Force a full repaint of the restored board
+        dirtyCount = 0;
+        allDirty = true;
+        memset(shownBuf, 0xFF, sizeof(uint16_t) * dim_w() * dim_h());
+
+        return true;
+    }
+
+    //
+    // Chord-reveal the cell at the current cursor position: if the cell
+    // is revealed and its value matches the number of flagged neighbors,
+    // feed every unflagged unrevealed neighbor into the flood-fill
+    // engine as one batch, producing a single dirty-set for one screen
+    // refresh. Returns the number of cells revealed.
+    //
+    TIndex chord()
+    {
+        // Only a revealed, numbered cell can be chorded
+        if (geti(curY, curX) != REVEAL)
+        {
+            return 0;
+        }
+
+        const TCell val = get(curY, curX);
+
+        if (val < '1' || val > '8')
+        {
+            return 0;
+        }
+
+        // The flag count around the cell must satisfy its value
+        TCell flags = 0;
+
+        for (TIndex h = curY-1 ; h <= curY+1 ; ++h)
+            for (TIndex w = curX-1 ; w <= curX+1 ; ++w)
+                if (geti(h, w) == FLAGGED)
+                    ++flags;
+
+        if (flags + '0' != val)
+        {
+            return 0;
+        }
+
+        // Reveal all the eligible neighbors in one batch
+        TIndex revealed = 0;
+
+        for (TIndex h = curY-1 ; h <= curY+1 ; ++h)
+            for (TIndex w = curX-1 ; w <= curX+1 ; ++w)
+                if (is_valid(h, w) && geti(h, w) == BLANK)
+                    revealed += flood_reveal(h, w);
+
+        return revealed;
+    }
+
+    //
+    // Returns the number of cells that must be successfully revealed in order
+    // to win the game
+    //
+    TIndex max_reveal() const
+    {
+        return ((dim_h() * dim_w()) - dim_m());
+    }
+
+    //
+    // Toggle the flag on the cell at the current cursor position
+    //
+    void flag()
+    {
+        if (geti(curY, curX) == BLANK)
+        {
+            // Toggle flag on
+            seti(curY, curX, FLAGGED);
+            ++flagCount;
+        }
+        else if (geti(curY, curX) == FLAGGED)
+        {
+            // Toggle flag off
+            seti(curY, curX, BLANK);
+            --flagCount;
+        }
+    }
+
+    //
+    // Compute the neighbor-mine count of every non-mine cell. The count
+    // is the classic separable 3x3 stencil over the mine mask: the mine
+    // bitset is expanded to one byte per cell, the three vertically
+    // adjacent rows are summed with the vectorized row-add kernel, then
+    // each row of vertical sums is summed horizontally the same way.
+    // Only the final write into the interleaved cell array is scalar,
+    // since a counted cell's own mask byte is always zero.
+    //
+    void count_all_neighbors()
+    {
+        const TIndex total = dim_w() * dim_h();
+        uint8_t * horizSum = rowScratch;
+        uint8_t * zeroRow = rowScratch + dim_w();
+
+        // Expand the packed mine bitmap into one byte per cell
+        bzero(mineMask, total);
+
+        for (TIndex i = 0 ; i < bit_words() ; ++i)
+        {
+            uint64_t bits = mineBits[i];
+
+            while (bits != 0)
+            {
+                mineMask[(i * 64) + __builtin_ctzll(bits)] = 1;
+                bits &= bits - 1;
+            }
+        }
+
+        bzero(zeroRow, dim_w());
+
+        // Vertical pass: sum each cell's column of three mask rows,
+        // substituting the zero row past the board edges
+        for (TIndex y = 0 ; y < dim_h() ; ++y)
+        {
+            const uint8_t * above = (y > 0)
+                ? mineMask + ((y - 1) * dim_w()) : zeroRow;
+            const uint8_t * below = (y < dim_h() - 1)
+                ? mineMask + ((y + 1) * dim_w()) : zeroRow;
+
+            rowAdd3(vertSum + (y * dim_w()), above, mineMask + (y * dim_w()),
+                    below, dim_w());
+        }
+
+        // Horizontal pass and writeback, one row at a time
+        for (TIndex y = 0 ; y < dim_h() ; ++y)
+        {
+            const uint8_t * v = vertSum + (y * dim_w());
+
+            if (dim_w() >= 3)
+            {
+                rowAdd3(horizSum + 1, v, v + 1, v + 2, dim_w() - 2);
+            }
+
+            horizSum[0] = v[0] + ((dim_w() > 1) ? v[1] : 0);
+
+            if (dim_w() > 1)
+            {
+                horizSum[dim_w()-1] = v[dim_w()-2] + v[dim_w()-1];
+            }
+
+            SCell * r = row(y);
+
+            for (TIndex x = 0 ; x < dim_w() ; ++x)
+            {
+                if (r[x].val != MINE)
+                {
+                    r[x].val = horizSum[x] + '0';
+                }
+            }
+        }
+    }
+
+    //
+    // Count the number of neighboring cells that have a mine
+    //
+    TCell count_neighbors(const TIndex y, const TIndex x) const
+    {
+        TCell count = 0;
+
+        for (TIndex h = y-1 ; h <= y+1 ; ++h)
+            for (TIndex w = x-1 ; w <= x+1 ; ++w)
+                if (is_valid(h, w) && !(h==y && w==x))
+                    if (get(h, w) == MINE)
+                        ++count;
+
+        return count;
+    }
+
+    // 
+    // Check if the cell location at y,x is in the valid range
+    //
+    bool is_valid(const TIndex y, const TIndex x) const
+    {
+        return (y >= 0 && y < dim_h() && x >= 0 && x < dim_w());
+    }
+
+    //
+    // Quit the game
+    //
+    void quit()
+    {
+        done = true;
+    }
+
+    //
+    // Check if the game is done
+    //
+    bool is_done() const
+    {
+        return done;
+    }
+
+    //
+    // Check if the game was won
+    //
+    bool is_win() const
+    {
+        return win;
+    }
+
+    //
+    // Check if the game was lost
+    //
+    bool is_lose() const
+    {
+        return lose;
+    }
+
+    //
+    // Returns the board dimensions
+    //
+    TIndex get_height() const
+    {
+        return dim_h();
+    }
+
+    TIndex get_width() const
+    {
+        return dim_w();
+    }
+
+    //
+    // Returns the number of cells revealed so far
+    //
+    TIndex get_reveal_count() const
+    {
+        return revealCount;
+    }
+
+    //
+    // Returns the number of flags placed so far
+    //
+    TIndex get_flag_count() const
+    {
+        return flagCount;
+    }
+
+    //
+    // Move the cursor directly to the cell at y,x
+    //
+    void set_cur(const TIndex y, const TIndex x)
+    {
+        if (is_valid(y, x))
+        {
+            curY = y;
+            curX = x;
+        }
+    }
+
+    //
+    // Move the cursor dy in the y direction and dx in the x direction,
+    // clamping to the board edges so a coalesced multi-key displacement
+    // stops at the edge just like repeated single steps would
+    //
+    void move_cur(const TIndex dy, const TIndex dx)
+    {
+        TIndex newY = dy + curY;
+        TIndex newX = dx + curX;
+
+        if (newY < 0)
+            newY = 0;
+        if (newY > dim_h() - 1)
+            newY = dim_h() - 1;
+        if (newX < 0)
+            newX = 0;
+        if (newX > dim_w() - 1)
+            newX = dim_w() - 1;
+
+        curY = newY;
+        curX = newX;
+    }
+
+    //
+    // Size the viewport from the field window. Boards that fit show in
+    // full; larger boards show a window-sized rectangle that scrolls.
+    //
+    void init_viewport()
+    {
+        viewY = 0;
+        viewX = 0;
+        viewHeight = dim_h();
+        viewWidth = dim_w();
+
+        if (pField != NULL)
+        {
+            int winHeight = 0;
+            int winWidth = 0;
+            getmaxyx(pField, winHeight, winWidth);
+
+            if ((TIndex) winHeight < viewHeight)
+            {
+                viewHeight = (TIndex) winHeight;
+            }
+
+            if ((TIndex) winWidth < viewWidth)
+            {
+                viewWidth = (TIndex) winWidth;
+            }
+        }
+    }
+
+    //
+    // Scroll the viewport the minimal distance needed to keep the
+    // cursor visible. A scroll remaps every visible cell to a new
+    // screen position, so the presented frame is poisoned and the next
+    // present() repaints the whole viewport.
+    //
+    void follow_cursor()
+    {
+        TIndex newViewY = viewY;
+        TIndex newViewX = viewX;
+
+        if (curY < newViewY)
+        {
+            newViewY = curY;
+        }
+        else if (curY > newViewY + viewHeight - 1)
+        {
+            newViewY = curY - viewHeight + 1;
+        }
+
+        if (curX < newViewX)
+        {
+            newViewX = curX;
+        }
+        else if (curX > newViewX + viewWidth - 1)
+        {
+            newViewX = curX - viewWidth + 1;
+        }
+
+        if (newViewY != viewY || newViewX != viewX)
+        {
+            viewY = newViewY;
+            viewX = newViewX;
+            allDirty = true;
+            memset(shownBuf, 0xFF, sizeof(uint16_t) * dim_w() * dim_h());
+        }
+    }
+
+    //
+    // Stage repaints with wnoutrefresh() instead of flushing each
+    // window, leaving the single doupdate() to the caller
+    //
+    void set_defer_refresh(const bool defer)
+    {
+        deferRefresh = defer;
+    }
+
+    //
+    // Update the score window and the mine field window
+    //
+    void update()
+    {
+        update_score();
+        update_field();
+    }
+
+    // Compose the single cell at y,x into the frame buffer
+    //
+    void compose_cell(const TIndex y, const TIndex x)
+    {
+        compose_cell_values(y, x, get(y, x), geti(y, x));
+    }
+
+    // Compose the cell at y,x into the frame buffer, given its
+    // already-fetched mine value and player input value
+    //
+    void compose_cell_values(const TIndex y, const TIndex x,
+                             const TCell val, const TCell ival)
+    {
+        uint16_t out;
+
+        if (ival == FLAGGED)
+        {
+            // Flagged cells
+            out = (uint16_t) FLAGGED;
+        }
+        else if (ival == REVEAL)
+        {
+            // Revealed cells with neighboring mines
+            if (val >= '1' && val <= '8')
+            {
+                out = (uint16_t) val | ((uint16_t) (val - '0') << 8);
+            }
+            else if (val == '0')
+            {
+                // Revealed cells with no neighboring mines
+                out = (uint16_t) ' ';
+            }
+            else
+            {
+                // The mines hit
+                out = (uint16_t) val;
+            }
+        }
+        else
+        {
+            // Unrevealed cells
+            out = (uint16_t) '.';
+        }
+
+        frameBuf[y * dim_w() + x] = out;
+    }
+
+    //
+    // Flush the composed frame to ncurses. Each row is diffed against
+    // the previously presented frame, changed cells are emitted as runs
+    // of waddch calls behind a single wmove, and color attribute
+    // changes are hoisted across runs of same-colored cells.
+    //
+    void present()
+    {
+        const bool colors = has_colors();
+        int curColor = 0;
+
+        for (TIndex sy = 0 ; sy < viewHeight ; ++sy)
+        {
+            const TIndex y = viewY + sy;
+            TIndex idx = (y * dim_w()) + viewX;
+
+            for (TIndex sx = 0 ; sx < viewWidth ; ++sx, ++idx)
+            {
+                if (frameBuf[idx] == shownBuf[idx])
+                {
+                    continue;
+                }
+
+                // Start of a changed run; emit it with one cursor move
+                wmove(pField, sy, sx);
+
+                while (sx < viewWidth && frameBuf[idx] != shownBuf[idx])
+                {
+                    const uint16_t cell = frameBuf[idx];
+                    const int color = cell >> 8;
+
+                    if (colors && color != curColor)
+                    {
+                        if (curColor != 0)
+                        {
+                            wattroff(pField, COLOR_PAIR(curColor));
+                        }
+
+                        if (color != 0)
+                        {
+                            wattron(pField, COLOR_PAIR(color));
+                        }
+
+                        curColor = color;
+                    }
+
+                    waddch(pField, (chtype) (cell & 0xFF));
+                    shownBuf[idx] = cell;
+
+                    ++sx;
+                    ++idx;
+                }
+            }
+        }
+
+        if (colors && curColor != 0)
+        {
+            wattroff(pField, COLOR_PAIR(curColor));
+        }
+    }
+
+    // Update the mine field window view
+    //
+    void update_field()
+    {
+        // Nothing to draw when running headless with no field window
+        if (pField == NULL)
+        {
+            return;
+        }
+
+        PROF_START(profT);
+
+        // Scroll the viewport if the cursor moved out of it
+        follow_cursor();
+
+        // A full recompose overwrites frame cells the end-of-game
+        // overlay may have claimed, so the overlay runs again after one
+        const bool recomposedAll = allDirty;
+
+        if (allDirty)
+        {
+            // Compose every visible cell, walking each row with a
+            // bumped pointer. Cells outside the viewport recompose
+            // when a scroll next sets allDirty.
+            for (TIndex y = viewY ; y < viewY + viewHeight ; ++y)
+            {
+                const SCell * r = row(y);
+
+                for (TIndex x = viewX ; x < viewX + viewWidth ; ++x)
+                {
+                    compose_cell_values(y, x, r[x].val, r[x].input);
+                }
+            }
+        }
+        else
+        {
+            // Compose only the cells that changed since the last refresh
+            for (TIndex i = 0 ; i < dirtyCount ; ++i)
+            {
+                const TIndex idx = dirtyList[i];
+                compose_cell(idx / dim_w(), idx % dim_w());
+            }
+        }
+
+        // All pending changes have been composed
+        dirtyCount = 0;
+        allDirty = false;
+
+        // If the player has lost, reveal the locations of all the mines.
+        // The mine and flag bitsets are walked a word (64 cells) at a
+        // time instead of scanning every cell, and only once per loss:
+        // the overlay stays composed in the frame buffer, so later
+        // repaints diff it like any other frame content.
+        if (lose && (!loseComposed || recomposedAll))
+        {
+            loseComposed = true;
+
+            for (TIndex i = 0 ; i < bit_words() ; ++i)
+            {
+                // Mines the player had not flagged
+                uint64_t showMines = mineBits[i] & ~flaggedBits[i];
+
+                // Flags placed on cells with no mine
+                uint64_t wrongFlags = flaggedBits[i] & ~mineBits[i];
+
+                while (showMines != 0)
+                {
+                    const TIndex idx = (i * 64) + __builtin_ctzll(showMines);
+
+                    // Indicate to the player the location of the mine,
+                    // highlighting the one hit by the cursor
+                    const bool hit = (idx == (curY * dim_w()) + curX);
+                    frameBuf[idx] = (uint16_t) MINE |
+                                    (hit ? (uint16_t) (3 << 8) : (uint16_t) 0);
+
+                    showMines &= showMines - 1;
+                }
+
+                while (wrongFlags != 0)
+                {
+                    const TIndex idx = (i * 64) + __builtin_ctzll(wrongFlags);
+
+                    // Indicate an incorrectly placed flag
+                    frameBuf[idx] = (uint16_t) WRONG_FLAG;
+
+                    wrongFlags &= wrongFlags - 1;
+                }
+            }
+        }
+
+        // Flush only the cells that differ from the presented frame
+        present();
+
+        // Move the cursor back to the correct place and refresh the window
+        wmove(pField, curY - viewY, curX - viewX);
+
+        if (deferRefresh)
+        {
+            wnoutrefresh(pField);
+        }
+        else
+        {
+            wrefresh(pField);
+        }
+
+        PROF_STOP(PROF_UPDATE_FIELD, profT);
+    }
+
+    //
+    // Update the score window view
+    //
+    void update_score()
+    {
+        // Nothing to draw when running headless with no score window
+        if (pScore == NULL)
+        {
+            return;
+        }
+
+        PROF_START(profT);
+
+        // Calculate the time delta since the start of the game (zero
+        // until the first reveal)
+        const uint64_t delta_ms = elapsed_ms();
+
+        // Print the scoreboard window
+        mvwprintw(pScore, 1, 0, "         Minesweeper");
+        mvwprintw(pScore, 3, 0, " [h] Move Left   [l] Move Right");
+        mvwprintw(pScore, 4, 0, " [j] Move Down   [k] Move Up");
+        mvwprintw(pScore, 5, 0, " [f] Flag Mine   [q] Quit");
+        mvwprintw(pScore, 6, 0, " [space] Reveal  [c] Chord");
+        mvwprintw(pScore, 7, 0, " [S] Snapshot    [n] New game");
+        wmove(pScore, 8, 0);
+        wclrtoeol(pScore);
+        mvwprintw(pScore, 8, 0, "Flags: %2d / %2d  Status: %s", flagCount, dim_m(), status());
+        wmove(pScore, 9, 0);
+        wclrtoeol(pScore);
+        mvwprintw(pScore, 9, 0, "Time: %d ms", delta_ms);
+
+        if (deferRefresh)
+        {
+            wnoutrefresh(pScore);
+        }
+        else
+        {
+            wrefresh(pScore);
+        }
+
+        PROF_STOP(PROF_UPDATE_SCORE, profT);
+    }
+
+    // Return a string representation of the outcome of the game
+    const char * status() const
+    {
+        if (lose)
+            return STR_LOSE;
+        if (win)
+            return STR_WIN;
+        if (done)
+            return STR_ABORTED;
+
+        return STR_PLAYING;
+    }
+};
+
+//
+// The runtime-sized board every interactive path uses, plus one
+// compile-time specialized variant per preset geometry. The batch
+// simulator dispatches preset boards to these so their hot loops run
+// with constant strides and bounds.
+//
+typedef TBoard<> SBoard;
+typedef TBoard<PRESETS[0].height, PRESETS[0].width, PRESETS[0].mines> SBoardBeginner;
+typedef TBoard<PRESETS[1].height, PRESETS[1].width, PRESETS[1].mines> SBoardIntermediate;
+typedef TBoard<PRESETS[2].height, PRESETS[2].width, PRESETS[2].mines> SBoardExpert;
+
+//
+// Replay log format: one SReplayHeader followed by a stream of
+// fixed-size SReplayEvent records. Events are written through stdio
+// buffering, so recording adds no syscall per keystroke.
+//
+static const uint32_t REPLAY_MAGIC = 0x4D535250;   // "MSRP"
+static const uint32_t REPLAY_VERSION = 1;
+
+struct SReplayHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t seed;
+    TIndex height;
+    TIndex width;
+    TIndex mines;
+    uint32_t pad;
+};
+
+struct SReplayEvent
+{
+    uint32_t delta_ms;
+    uint8_t key;
+};
+
+//
+// Native constraint solver. Operates directly on the board state
+// through the frontier/constraint API: trivial deductions over the
+// number cells first, then subset elimination between overlapping
+// frontier constraints. Used by --autoplay and --grade.
+//
+
+//
+// Collect the active constraints: every revealed numbered cell adjacent
+// to a frontier cell, each taken once. 'seen' is a caller-provided
+// byte-per-cell scratch map. Returns the number collected.
+//
+//
+// Reusable solver scratch, allocated once per playout and shared by
+// every deduction round: the constraint array grows to the live
+// frontier bound (each frontier cell has at most eight revealed
+// neighbors) and the dedupe map is generation-stamped, so a round
+// allocates nothing and never clears board-sized memory.
+//
+struct SSolverScratch
+{
+    SConstraint * cons = NULL;
+    TIndex consCapacity = 0;
+    uint32_t * seen = NULL;
+    uint32_t gen = 0;
+};
+
+template <typename TB>
+void solver_scratch_init(SSolverScratch & scratch, const TB & board)
+{
+    const size_t total = (size_t) board.get_width() *
+                         (size_t) board.get_height();
+
+    scratch.seen = (uint32_t *) malloc(sizeof(uint32_t) * total);
+
+    if (scratch.seen == NULL)
+    {
+        fprintf(stderr, "minesweeper: cannot allocate solver scratch\n");
+        exit(EXIT_FAILURE);
+    }
+
+    bzero(scratch.seen, sizeof(uint32_t) * total);
+    scratch.gen = 0;
+}
+
+void solver_scratch_free(SSolverScratch & scratch)
+{
+    free(scratch.cons);
+    free(scratch.seen);
+    scratch.cons = NULL;
+    scratch.consCapacity = 0;
+    scratch.seen = NULL;
+}
+
+template <typename TB>
+TIndex solver_gather(TB & board, SSolverScratch & scratch)
+{
+    const TIndex width = board.get_width();
+    const TIndex height = board.get_height();
+    TIndex count = 0;
+
+    // Size the constraint array by the live frontier instead of the
+    // whole board
+    const int64_t bound = (int64_t) board.frontier_size() * 8;
+    const int64_t cells = (int64_t) width * (int64_t) height;
+    const TIndex maxOut = (TIndex) (bound < cells ? bound : cells);
+
+    if (scratch.consCapacity < maxOut)
+    {
+        free(scratch.cons);
+        scratch.cons = (SConstraint *) malloc(sizeof(SConstraint) * maxOut);
+
+        if (scratch.cons == NULL)
+        {
+            fprintf(stderr, "minesweeper: cannot allocate solver scratch\n");
+            exit(EXIT_FAILURE);
+        }
+
+        scratch.consCapacity = maxOut;
+    }
+
+    SConstraint * const out = scratch.cons;
+
+    // A fresh generation invalidates every stamp from earlier rounds
+    // without touching the map (re-zeroing only on the 2^32 wrap)
+    if (++scratch.gen == 0)
+    {
+        bzero(scratch.seen, sizeof(uint32_t) * (size_t) width *
+              (size_t) height);
+        scratch.gen = 1;
+    }
+
+    uint32_t * const seen = scratch.seen;
+
+    for (TIndex idx = board.next_frontier(0) ;
+         idx != (TIndex) ERROR && count < maxOut ;
+         idx = board.next_frontier(idx + 1))
+    {
+        const TIndex y = idx / width;
+        const TIndex x = idx % width;
+
+        // The constraints on this frontier cell come from its revealed
+        // neighbors
+        for (TIndex h = y-1 ; h <= y+1 ; ++h)
+        {
+            for (TIndex w = x-1 ; w <= x+1 ; ++w)
+            {
+                if (h < 0 || h >= height || w < 0 || w >= width)
+                {
+                    continue;
+                }
+
+                const TIndex n = h * width + w;
+
+                if (seen[n] == scratch.gen)
+                {
+                    continue;
+                }
+
+                seen[n] = scratch.gen;
+
+                SConstraint c;
+
+                if (board.get_constraint(h, w, c) && c.unknownCount > 0 &&
+                    count < maxOut)
+                {
+                    out[count] = c;
+                    ++count;
+                }
+            }
+        }
+
+        if (idx + 1 >= width * height)
+        {
+            break;
+        }
+    }
+
+    return count;
+}
+
+//
+// Check whether every unknown cell of constraint a also appears in
+// constraint b
+//
+bool solver_subset(const SConstraint & a, const SConstraint & b)
+{
+    for (int i = 0 ; i < a.unknownCount ; ++i)
+    {
+        bool found = false;
+
+        for (int j = 0 ; j < b.unknownCount ; ++j)
+        {
+            if (a.unknownY[i] == b.unknownY[j] &&
+                a.unknownX[i] == b.unknownX[j])
+            {
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//
+// Run one round of solver deductions against the board. Returns the
+// number of flag/reveal actions performed; zero means the solver is
+// stuck and must guess.
+//
+template <typename TB>
+TIndex solver_step(TB & board, SSolverScratch & scratch)
+{
+    const TIndex count = solver_gather(board, scratch);
+    const SConstraint * const cons = scratch.cons;
+    TIndex actions = 0;
+
+    // Trivial deductions: a satisfied cell chords its unknowns open,
+    // and a cell whose remaining mines equal its unknowns flags them all
+    for (TIndex i = 0 ; i < count && !board.is_done() ; ++i)
+    {
+        const SConstraint & c = cons[i];
+        const TCell minesLeft = c.value - '0' - c.flags;
+
+        if (minesLeft == 0)
+        {
+            board.set_cur(c.y, c.x);
+            actions += board.chord();
+        }
+        else if (minesLeft == c.unknownCount)
+        {
+            for (int u = 0 ; u < c.unknownCount ; ++u)
+            {
+                if (board.geti(c.unknownY[u], c.unknownX[u]) == BLANK)
+                {
+                    board.set_cur(c.unknownY[u], c.unknownX[u]);
+                    board.flag();
+                    ++actions;
+                }
+            }
+        }
+    }
+
+    // Subset elimination: when constraint a's unknowns are contained in
+    // constraint b's, the difference cells carry the difference of the
+    // remaining mine counts
+    for (TIndex i = 0 ; i < count && actions == 0 ; ++i)
+    {
+        for (TIndex j = 0 ; j < count && actions == 0 ; ++j)
+        {
+            const SConstraint & a = cons[i];
+            const SConstraint & b = cons[j];
+
+            if (i == j || a.unknownCount >= b.unknownCount ||
+                !solver_subset(a, b))
+            {
+                continue;
+            }
+
+            const TCell minesA = a.value - '0' - a.flags;
+            const TCell minesB = b.value - '0' - b.flags;
+            const TCell remCount = b.unknownCount - a.unknownCount;
+
+            if (minesB - minesA != remCount && minesB != minesA)
+            {
+                continue;
+            }
+
+            // Act on the cells in b but not in a
+            for (int u = 0 ; u < b.unknownCount ; ++u)
+            {
+                bool inA = false;
+
+                for (int v = 0 ; v < a.unknownCount ; ++v)
+                {
+                    if (b.unknownY[u] == a.unknownY[v] &&
+                        b.unknownX[u] == a.unknownX[v])
+                    {
+                        inA = true;
+                        break;
+                    }
+                }
+
+                if (inA)
+                {
+                    continue;
+                }
+
+                if (minesB - minesA == remCount)
+                {
+                    // Every difference cell holds a mine
+                    if (board.geti(b.unknownY[u], b.unknownX[u]) == BLANK)
+                    {
+                        board.set_cur(b.unknownY[u], b.unknownX[u]);
+                        board.flag();
+                        ++actions;
+                    }
+                }
+                else
+                {
+                    // Every difference cell is safe
+                    board.set_cur(b.unknownY[u], b.unknownX[u]);
+                    actions += board.reveal();
+                }
+            }
+        }
+    }
+
+    return actions;
+}
+
+//
+// Reveal a random unknown cell when no deduction exists. Returns false
+// if there is nothing left to guess.
+//
+template <typename TB>
+bool solver_guess(TB & board)
+{
+    const TIndex width = board.get_width();
+    const TIndex total = width * board.get_height();
+
+    // Search forward from a random spot, wrapping once, for an
+    // unrevealed cell that is not flagged
+    TIndex idx = board.next_unrevealed(random(0, total));
+
+    for (int pass = 0 ; pass < 2 ; ++pass)
+    {
+        while (idx != (TIndex) ERROR)
+        {
+            if (board.geti(idx / width, idx % width) == BLANK)
+            {
+                board.set_cur(idx / width, idx % width);
+                board.reveal();
+                return true;
+            }
+
+            idx = (idx + 1 < total) ? board.next_unrevealed(idx + 1)
+                                    : (TIndex) ERROR;
+        }
+
+        idx = board.next_unrevealed(0);
+    }
+
+    return false;
+}
+
+//
+// Play one automated game to completion with the constraint solver
+//
+template <typename TB>
+void play_solver_game(TB & board, SSolverScratch & scratch)
+{
+    // Open on the center cell
+    board.set_cur(board.get_height() / 2, board.get_width() / 2);
+    board.reveal();
+
+    while (!board.is_done())
+    {
+        if (solver_step(board, scratch) == 0 && !board.is_done())
+        {
+            if (!solver_guess(board))
+            {
+                board.quit();
+            }
+        }
+    }
+}
+
+//
+// Play one automated game to completion with random reveals
+//
+template <typename TB>
+void play_random_game(TB & board)
+{
+    const TIndex total = board.get_height() * board.get_width();
+
+    while (!board.is_done())
+    {
+        // Pick a random cell that has not been revealed yet, using the
+        // bitset query instead of rejection sampling
+        TIndex idx = board.next_unrevealed(random(0, total));
+
+        if (idx == (TIndex) ERROR)
+        {
+            idx = board.next_unrevealed(0);
+        }
+
+        if (idx == (TIndex) ERROR)
+        {
+            break;
+        }
+
+        board.set_cur(idx / board.get_width(), idx % board.get_width());
+        board.reveal();
+    }
+}
+
+//
+// Whether headless games are played by the solver (--grade) or at
+// random
+//
+static bool headlessSolver = false;
+
+//
+// Per-worker simulation state: its geometry, PRNG seed, and fixed share
+// of the batch in, and its privately accumulated results out. Workers
+// never share accumulators, so no locks are needed; the totals are
+// summed after the joins.
+//
+struct SWorker
+{
+    pthread_t thread;
+    TIndex height;
+    TIndex width;
+    TIndex mines;
+    uint64_t seed;
+    long games;
+    long wins;
+    long long cellsRevealed;
+};
+
+//
+// Simulation worker. Seeds its thread-local PRNG, carves one board out
+// of a pre-allocated arena so the steady state performs no heap
+// allocation, and plays its fixed share of the batch. Static shares
+// (instead of a shared claim counter) keep each worker's game sequence
+// independent of thread scheduling, so a seeded batch produces the
+// same aggregate results on every run.
+//
+template <typename TB>
+void headless_run(SWorker * const worker)
+{
+    void * arena = malloc(TB::arena_size(worker->height, worker->width));
+
+    if (arena == NULL)
+    {
+        fprintf(stderr, "minesweeper: cannot allocate a %dx%d board\n",
+                worker->height, worker->width);
+        exit(EXIT_FAILURE);
+    }
+
+    TB board(worker->height, worker->width, worker->mines,
+             NULL, NULL, arena);
+
+    // One solver scratch serves every game this worker plays
+    SSolverScratch scratch;
+    solver_scratch_init(scratch, board);
+
+    for (long g = 0 ; g < worker->games ; ++g)
+    {
+        board.reset();
+
+        if (headlessSolver)
+        {
+            play_solver_game(board, scratch);
+        }
+        else
+        {
+            play_random_game(board);
+        }
+
+        if (board.is_win())
+        {
+            ++worker->wins;
+        }
+
+        worker->cellsRevealed += board.get_reveal_count();
+    }
+
+    solver_scratch_free(scratch);
+    free(arena);
+}
+
+void * headless_worker(void * const arg)
+{
+    SWorker * const worker = (SWorker *) arg;
+
+    seed_random(worker->seed);
+
+    // Preset geometries run on their compile-time specialized board
+    // variants; everything else takes the runtime-sized board
+    if (worker->height == PRESETS[0].height &&
+        worker->width == PRESETS[0].width &&
+        worker->mines == PRESETS[0].mines)
+    {
+        headless_run<SBoardBeginner>(worker);
+    }
+    else if (worker->height == PRESETS[1].height &&
+             worker->width == PRESETS[1].width &&
+             worker->mines == PRESETS[1].mines)
+    {
+        headless_run<SBoardIntermediate>(worker);
+    }
+    else if (worker->height == PRESETS[2].height &&
+             worker->width == PRESETS[2].width &&
+             worker->mines == PRESETS[2].mines)
+    {
+        headless_run<SBoardExpert>(worker);
+    }
+    else
+    {
+        headless_run<SBoard>(worker);
+    }
+
+    return NULL;
+}
+
+//
+// Run a batch of automated games with no terminal output, spread across
+// a pool of worker threads. Each game is constructed with null render
+// targets and driven by random reveals, and aggregate results are
+// reported when the batch completes.
+//
+void headless(const TIndex height, const TIndex width, const TIndex mines,
+              const long games, const int threads)
+{
+    struct timespec batchStart;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &batchStart);
+
+    SWorker * workers = (SWorker *) malloc(sizeof(SWorker) * threads);
+    bzero(workers, sizeof(SWorker) * threads);
+
+    for (int t = 0 ; t < threads ; ++t)
+    {
+        workers[t].height = height;
+        workers[t].width = width;
+        workers[t].mines = mines;
+
+        // Fixed share of the batch, with the remainder spread over the
+        // leading workers
+        workers[t].games = (games / threads) + (t < games % threads);
+
+        // Derive each worker's seed from the main PRNG stream. With the
+        // static shares above, a -s seed makes the whole batch
+        // reproducible at any thread count.
+        workers[t].seed = random64();
+    }
+
+    if (threads == 1)
+    {
+        // Run the single worker inline
+        headless_worker(&workers[0]);
+    }
+    else
+    {
+        for (int t = 0 ; t < threads ; ++t)
+        {
+            pthread_create(&workers[t].thread, NULL, headless_worker,
+                           &workers[t]);
+        }
+
+        for (int t = 0 ; t < threads ; ++t)
+        {
+            pthread_join(workers[t].thread, NULL);
+        }
+    }
+
+    // Sum the per-worker accumulators
+    long wins = 0;
+    long long cellsRevealed = 0;
+
+    for (int t = 0 ; t < threads ; ++t)
+    {
+        wins += workers[t].wins;
+        cellsRevealed += workers[t].cellsRevealed;
+    }
+
+    free(workers);
+
+    // Calculate the elapsed time of the batch
+    struct timespec batchEnd;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &batchEnd);
+    uint64_t delta_ms = ((batchEnd.tv_sec - batchStart.tv_sec) * 1000000 +
+                        (batchEnd.tv_nsec - batchStart.tv_nsec) / 1000) / 1000;
+
+    // Report the aggregate results
+    printf("Games:          %ld\n", games);
+    printf("Threads:        %d\n", threads);
+    printf("Wins:           %ld\n", wins);
+    printf("Losses:         %ld\n", games - wins);
+    printf("Win rate:       %.2f%%\n", 100.0 * wins / games);
+    printf("Cells revealed: %lld\n", cellsRevealed);
+    printf("Elapsed:        %lu ms\n", (unsigned long) delta_ms);
+
+    if (delta_ms > 0)
+    {
+        printf("Games/sec:      %.1f\n", 1000.0 * games / delta_ms);
+    }
+
+    prof_dump();
+}
+
+//
+// Board generator service. A background thread keeps a small queue of
+// fully prepared backing arenas (mines placed, neighbors counted, shown
+// frame poisoned) for the active geometry, so starting a new game on the
+// main thread is just an arena swap. The generator runs its own seeded
+// PRNG stream, and arenas are handed back for rebuilding after a swap,
+// so the pool never grows past its fixed depth.
+//
+static const int GENERATOR_DEPTH = 4;
+
+static pthread_t generatorThread;
+static pthread_mutex_t generatorLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t generatorWake = PTHREAD_COND_INITIALIZER;
+
+// Ready arenas form a FIFO ring handed out in build order, so the
+// k-th new game always receives the k-th board of the generator
+// stream, no matter how full the queue is when it is taken
+static void * generatorReady[GENERATOR_DEPTH];
+static int generatorReadyHead = 0;
+static int generatorReadyCount = 0;
+static void * generatorFree[GENERATOR_DEPTH];
+static int generatorFreeCount = 0;
+static int generatorAllocated = 0;
+
+static TIndex generatorHeight = 0;
+static TIndex generatorWidth = 0;
+static TIndex generatorMines = 0;
+static uint64_t generatorSeed = 0;
+static bool generatorRunning = false;
+
+//
+// Generator thread: build boards into recycled (or newly allocated)
+// arenas whenever the ready queue has room
+//
+void * generator_main(void *)
+{
+    seed_random(generatorSeed);
+
+    pthread_mutex_lock(&generatorLock);
+
+    while (generatorRunning)
+    {
+        // Wait for room in the ready queue and an arena to build into
+        if (generatorReadyCount == GENERATOR_DEPTH ||
+            (generatorFreeCount == 0 && generatorAllocated == GENERATOR_DEPTH))
+        {
+            pthread_cond_wait(&generatorWake, &generatorLock);
+            continue;
+        }
+
+        void * arena;
+
+        if (generatorFreeCount > 0)
+        {
+            arena = generatorFree[--generatorFreeCount];
+        }
+        else
+        {
+            arena = malloc(SBoard::arena_size(generatorHeight, generatorWidth));
+
+            if (arena == NULL)
+            {
+                // The interactive board of the same geometry already
+                // allocated, so treat a refused prefetch arena as fatal
+                // rather than limping along without the service
+                fprintf(stderr,
+                        "minesweeper: cannot allocate a %dx%d board\n",
+                        generatorHeight, generatorWidth);
+                exit(EXIT_FAILURE);
+            }
+
+            ++generatorAllocated;
+        }
+
+        const TIndex height = generatorHeight;
+        const TIndex width = generatorWidth;
+        const TIndex mines = generatorMines;
+
+        // Build outside the lock; the arena is private until queued
+        pthread_mutex_unlock(&generatorLock);
+
+        {
+            SBoard board(height, width, mines, NULL, NULL, arena);
+        }
+
+        pthread_mutex_lock(&generatorLock);
+
+        generatorReady[(generatorReadyHead + generatorReadyCount) %
+                       GENERATOR_DEPTH] = arena;
+        ++generatorReadyCount;
+        pthread_cond_broadcast(&generatorWake);
+    }
+
+    pthread_mutex_unlock(&generatorLock);
+
+    return NULL;
+}
+
+//
+// Start the generator service for one geometry
+//
+void generator_start(const TIndex height, const TIndex width,
+                     const TIndex mines, const uint64_t seed)
+{
+    generatorHeight = height;
+    generatorWidth = width;
+    generatorMines = mines;
+    generatorSeed = seed;
+    generatorRunning = true;
+
+    pthread_create(&generatorThread, NULL, generator_main, NULL);
+}
+
+//
+// Take a prepared arena off the ready queue, waiting for the generator
+// if none is built yet. Blocking keeps the board sequence a pure
+// function of the generator stream's seed, so recordings that contain
+// new-game events replay identically regardless of generator timing.
+// Returns NULL only if the service is not running.
+//
+void * generator_take()
+{
+    void * arena = NULL;
+
+    pthread_mutex_lock(&generatorLock);
+
+    while (generatorReadyCount == 0 && generatorRunning)
+    {
+        pthread_cond_wait(&generatorWake, &generatorLock);
+    }
+
+    if (generatorReadyCount > 0)
+    {
+        arena = generatorReady[generatorReadyHead];
+        generatorReadyHead = (generatorReadyHead + 1) % GENERATOR_DEPTH;
+        --generatorReadyCount;
+        pthread_cond_broadcast(&generatorWake);
+    }
+
+    pthread_mutex_unlock(&generatorLock);
+
+    return arena;
+}
+
+//
+// Hand a retired arena back to the generator for rebuilding
+//
+void generator_recycle(void * const arena)
+{
+    pthread_mutex_lock(&generatorLock);
+
+    generatorFree[generatorFreeCount++] = arena;
+    pthread_cond_broadcast(&generatorWake);
+
+    pthread_mutex_unlock(&generatorLock);
+}
+
+//
+// Stop the generator thread and free every arena it still holds
+//
+void generator_stop()
+{
+    pthread_mutex_lock(&generatorLock);
+    generatorRunning = false;
+    pthread_cond_broadcast(&generatorWake);
+    pthread_mutex_unlock(&generatorLock);
+
+    pthread_join(generatorThread, NULL);
+
+    while (generatorReadyCount > 0)
+    {
+        free(generatorReady[generatorReadyHead]);
+        generatorReadyHead = (generatorReadyHead + 1) % GENERATOR_DEPTH;
+        --generatorReadyCount;
+    }
+
+    generatorReadyHead = 0;
+
+    while (generatorFreeCount > 0)
+    {
+        free(generatorFree[--generatorFreeCount]);
+    }
+
+    generatorAllocated = 0;
+}
+
+//
+// Play through the mine sweeper game. If recordPath is given, every
+// action is logged with its timestamp so the game can be reconstructed.
+// If replayFile is given, input comes from the log instead of the
+// keyboard, in real time unless replayFast is set.
+//
+void minesweeper(const TIndex height, const TIndex width, const TIndex mines,
+                 const uint64_t seed, const char * const recordPath,
+                 FILE * const replayFile, const bool replayFast,
+                 const int tick, const char * const snapshotPath,
+                 const SSnapshotHeader * const restoreHeader,
+                 FILE * const restoreFile, const bool autoplay)
+{
+    // Open the replay log and write its header up front
+    FILE * recordFile = NULL;
+
+    if (recordPath != NULL)
+    {
+        recordFile = fopen(recordPath, "wb");
+
+        if (recordFile != NULL)
+        {
+            SReplayHeader header;
+            header.magic = REPLAY_MAGIC;
+            header.version = REPLAY_VERSION;
+            header.seed = seed;
+            header.height = height;
+            header.width = width;
+            header.mines = mines;
+            header.pad = 0;
+
+            fwrite(&header, sizeof(header), 1, recordFile);
+        }
+    }
+
+    // Initialize ncurses
+    initscr();
+
+    // If the terminal supports colors, initialize color pairs
+    if (has_colors())
+    {
+        start_color();
+        init_pair(1, COLOR_BLUE, COLOR_BLACK);
+        init_pair(2, COLOR_GREEN, COLOR_BLACK);
+        init_pair(3, COLOR_RED, COLOR_BLACK);
+        init_pair(4, COLOR_MAGENTA, COLOR_BLACK);
+        init_pair(5, COLOR_RED, COLOR_BLACK);
+        init_pair(6, COLOR_CYAN, COLOR_BLACK);
+        init_pair(7, COLOR_WHITE, COLOR_BLACK);
+        init_pair(8, COLOR_WHITE, COLOR_BLACK);
+    }
+
+    // Ncurses setings
+    cbreak();
+    noecho();
+
+    // Ncurses windows for the scoreboard and mine field. The field
+    // window is clamped to the screen; larger boards scroll behind a
+    // viewport that follows the cursor.
+    int fieldHeight = (int) height;
+    int fieldWidth = (int) width;
+
+    if (fieldHeight > LINES - 12)
+    {
+        fieldHeight = LINES - 12;
+    }
+
+    if (fieldWidth > COLS - 1)
+    {
+        fieldWidth = COLS - 1;
+    }
+
+    if (fieldHeight < 1)
+    {
+        fieldHeight = 1;
+    }
+
+    if (fieldWidth < 1)
+    {
+        fieldWidth = 1;
+    }
+
+    WINDOW * pScore = newwin(11, 31, 1, 1);
+    WINDOW * pField = newwin(fieldHeight, fieldWidth, 12, 1);
+
+    // Create the mine sweeper board and update the view
+    SBoard board(height, width, mines, pScore, pField);
+
+    // Resume from a snapshot instead of starting fresh
+    if (restoreHeader != NULL && restoreFile != NULL)
+    {
+        board.restore_snapshot(*restoreHeader, restoreFile);
+    }
+
+    board.update();
+
+    // Solver scratch for autoplay, reused across deduction rounds
+    SSolverScratch solverScratch;
+
+    if (autoplay)
+    {
+        solver_scratch_init(solverScratch, board);
+    }
+
+    // Pre-build replacement boards in the background. The generator
+    // stream is seeded from the main stream after the first board is
+    // placed, so replays reconstruct every board in order.
+    generator_start(height, width, mines, random64());
+
+    // Set a timeout for input, so the timer/clock updates automatically
+    nodelay(pField, true);
+    wtimeout(pField, tick);
+
+    // Timestamp of the start of the game, for replay event timestamps
+    struct timespec gameStart;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &gameStart);
+
+    // Main Loop
+    while (!board.is_done())
+    {
+        // In autoplay mode the solver supplies the moves, one deduction
+        // round per frame so the game can be watched
+        if (autoplay)
+        {
+            if (board.get_reveal_count() == 0)
+            {
+                board.set_cur(height / 2, width / 2);
+                board.reveal();
+            }
+            else if (solver_step(board, solverScratch) == 0 &&
+                     !board.is_done())
+            {
+                if (!solver_guess(board))
+                {
+                    board.quit();
+                }
+            }
+
+            board.update();
+            usleep(50000);
+            continue;
+        }
+
+        int key = ERR;
+
+        if (replayFile != NULL)
+        {
+            // Take the next action from the replay log. A truncated or
+            // exhausted log ends the game.
+            SReplayEvent event;
+
+            if (fread(&event, sizeof(event), 1, replayFile) != 1)
+            {
+                key = 'q';
+            }
+            else
+            {
+                key = event.key;
+
+                if (!replayFast)
+                {
+                    // Sleep until the recorded timestamp comes up
+                    struct timespec now;
+                    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+                    uint64_t elapsed_ms =
+                        ((now.tv_sec - gameStart.tv_sec) * 1000000 +
+                         (now.tv_nsec - gameStart.tv_nsec) / 1000) / 1000;
+
+                    if (event.delta_ms > elapsed_ms)
+                    {
+                        usleep((event.delta_ms - elapsed_ms) * 1000);
+                    }
+                }
+            }
+        }
+        else
+        {
+            key = wgetch(pField);
+        }
+
+        if (key == ERR)
+        {
+            // Timer tick with no input: only the score clock needs a
+            // repaint, not the (unchanged) mine field
+            board.update_score();
+            continue;
+        }
+
+        PROF_START(profLoop);
+
+        // Drain every queued input event before rendering, coalescing
+        // consecutive cursor moves into one displacement, so held-key
+        // autorepeat costs one redraw per batch instead of one per key
+        TIndex dy = 0;
+        TIndex dx = 0;
+
+        while (key != ERR && !board.is_done())
+        {
+            // Normalize the arrow keys to their vi equivalents, so
+            // every action fits in one replay-log byte
+            switch (key)
+            {
+                case KEY_DOWN:
+                    key = 'j';
+                    break;
+                case KEY_UP:
+                    key = 'k';
+                    break;
+                case KEY_LEFT:
+                    key = 'h';
+                    break;
+                case KEY_RIGHT:
+                    key = 'l';
+                    break;
+            }
+
+            // Log the action with its timestamp (buffered; no syscall
+            // here)
+            if (recordFile != NULL)
+            {
+                struct timespec now;
+                clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+
+                SReplayEvent event;
+                event.delta_ms = (uint32_t)
+                    (((now.tv_sec - gameStart.tv_sec) * 1000000 +
+                      (now.tv_nsec - gameStart.tv_nsec) / 1000) / 1000);
+                event.key = (uint8_t) key;
+
+                fwrite(&event, sizeof(event), 1, recordFile);
+            }
+
+            if (key == 'j' || key == 'k' || key == 'h' || key == 'l')
+            {
+                // Accumulate the displacement; it is applied when a
+                // non-move action (or the end of the batch) arrives
+                dy += (key == 'j') - (key == 'k');
+                dx += (key == 'l') - (key == 'h');
+            }
+            else
+            {
+                // Non-move actions act at the coalesced cursor position
+                if (dy != 0 || dx != 0)
+                {
+                    board.move_cur(dy, dx);
+                    dy = 0;
+                    dx = 0;
+                }
+
+                switch (key)
+                {
+                    case ' ':
+                        board.reveal();
+                        break;
+                    case 'f':
+                        board.flag();
+                        break;
+                    case 'c':
+                        board.chord();
+                        break;
+                    case 'q':
+                        board.quit();
+                        break;
+                    case 'S':
+                        board.save_snapshot(snapshotPath);
+                        break;
+                    case 'n':
+                    {
+                        // Swap in a prefetched board; generator_take
+                        // blocks until one is ready, so the board
+                        // sequence never depends on generator timing
+                        void * prepared = generator_take();
+
+                        if (prepared != NULL)
+                        {
+                            generator_recycle(board.adopt_backing(prepared));
+                        }
+                        break;
+                    }
+                }
+            }
+
+            // Replay events stay one per frame so their timing holds
+            if (replayFile != NULL)
+            {
+                break;
+            }
+
+            // Poll for more queued input without blocking
+            wtimeout(pField, 0);
+            key = wgetch(pField);
+            wtimeout(pField, tick);
+        }
+
+        if (dy != 0 || dx != 0)
+        {
+            board.move_cur(dy, dx);
+        }
+
+        // Render once for the whole drained batch
+        board.update();
+
+        PROF_STOP(PROF_LOOP, profLoop);
+    }
+
+    generator_stop();
+    solver_scratch_free(solverScratch);
+
+    // Ncurses end
+    endwin();
+
+    prof_dump();
+
+    // Fold the finished game into the persistent statistics; quitting
+    // without finishing is not counted
+    if (board.is_win() || board.is_lose())
+    {
+        stats_record_game(height, width, mines, board.is_win(),
+                          board.elapsed_ms(), board.get_reveal_count(),
+                          board.get_flag_count());
+    }
+
+    if (recordFile != NULL)
+    {
+        fclose(recordFile);
+    }
+}
+
+//
+// Play several boards of the same geometry side by side. One input
+// loop feeds the focused board (tab cycles focus), and all repaints
+// are staged with wnoutrefresh() and flushed by a single doupdate()
+// per frame, so N boards cost one terminal write instead of N.
+//
+void minesweeper_multi(const TIndex height, const TIndex width,
+                       const TIndex mines, const int boards,
+                       const int tick)
+{
+    initscr();
+
+    if (has_colors())
+    {
+        start_color();
+        init_pair(1, COLOR_BLUE, COLOR_BLACK);
+        init_pair(2, COLOR_GREEN, COLOR_BLACK);
+        init_pair(3, COLOR_RED, COLOR_BLACK);
+        init_pair(4, COLOR_MAGENTA, COLOR_BLACK);
+        init_pair(5, COLOR_RED, COLOR_BLACK);
+        init_pair(6, COLOR_CYAN, COLOR_BLACK);
+        init_pair(7, COLOR_WHITE, COLOR_BLACK);
+        init_pair(8, COLOR_WHITE, COLOR_BLACK);
+    }
+
+    cbreak();
+    noecho();
+
+    // Divide the screen into one column per board, each clamped like
+    // the single-board window; oversized boards scroll per-viewport
+    int fieldHeight = (int) height;
+    int fieldWidth = (int) width;
+
+    const int columnWidth = ((COLS - 1) / boards) - 2;
+
+    if (fieldHeight > LINES - 12)
+    {
+        fieldHeight = LINES - 12;
+    }
+
+    if (fieldWidth > columnWidth)
+    {
+        fieldWidth = columnWidth;
+    }
+
+    if (fieldHeight < 1)
+    {
+        fieldHeight = 1;
+    }
+
+    if (fieldWidth < 1)
+    {
+        fieldWidth = 1;
+    }
+
+    WINDOW * pScore = newwin(11, 31, 1, 1);
+
+    SBoard ** board = (SBoard **) malloc(sizeof(SBoard *) * boards);
+    WINDOW ** pField = (WINDOW **) malloc(sizeof(WINDOW *) * boards);
+
+    for (int b = 0 ; b < boards ; ++b)
+    {
+        pField[b] = newwin(fieldHeight, fieldWidth, 12,
+                           1 + b * (fieldWidth + 2));
+        board[b] = new SBoard(height, width, mines, pScore, pField[b]);
+        board[b]->set_defer_refresh(true);
+    }
+
+    // All boards share one geometry, so one generator feeds them all
+    generator_start(height, width, mines, random64());
+
+    // Input arrives through the score window, so the per-board field
+    // windows never refresh implicitly
+    nodelay(pScore, true);
+    wtimeout(pScore, tick);
+
+    int focus = 0;
+    bool running = true;
+
+    // Paint every board once
+    for (int b = boards - 1 ; b >= 0 ; --b)
+    {
+        board[b]->update_field();
+    }
+
+    board[focus]->update_score();
+    doupdate();
+
+    while (running)
+    {
+        int key = wgetch(pScore);
+
+        // Drain the queued input, coalescing cursor moves like the
+        // single-board loop
+        TIndex dy = 0;
+        TIndex dx = 0;
+
+        while (key != ERR)
         {
-            for (TCell x = 0 ; x < width ; ++x)
+            switch (key)
             {
-                // Grab the mine value and the player input value
-                const TCell val = get(y, x);
-                const TCell ival = geti(y, x);
+                case KEY_DOWN:
+                    key = 'j';
+                    break;
+                case KEY_UP:
+                    key = 'k';
+                    break;
+                case KEY_LEFT:
+                    key = 'h';
+                    break;
+                case KEY_RIGHT:
+                    key = 'l';
+                    break;
+            }
 
-                if (ival == FLAGGED)
+            if (key == 'j' || key == 'k' || key == 'h' || key == 'l')
+            {
+                dy += (key == 'j') - (key == 'k');
+                dx += (key == 'l') - (key == 'h');
+            }
+            else
+            {
+                if (dy != 0 || dx != 0)
                 {
-                    // Flagged cells
-                    mvwaddch(pField, y, x, FLAGGED);
+                    board[focus]->move_cur(dy, dx);
+                    dy = 0;
+                    dx = 0;
                 }
-                else if (ival == REVEAL)
+
+                switch (key)
                 {
-                    // Revealed cells with neighboring mines
-                    if (val >= '1' && val <= '8')
+                    case '\t':
+                        focus = (focus + 1) % boards;
+                        break;
+                    case ' ':
+                        board[focus]->reveal();
+                        break;
+                    case 'f':
+                        board[focus]->flag();
+                        break;
+                    case 'c':
+                        board[focus]->chord();
+                        break;
+                    case 'q':
+                        running = false;
+                        break;
+                    case 'n':
                     {
-                        if (has_colors())
-                        {
-                            wattron(pField, COLOR_PAIR(val - '0'));
-                        }
-
-                        mvwaddch(pField, y, x, val);
+                        void * prepared = generator_take();
 
-                        if (has_colors())
+                        if (prepared != NULL)
                         {
-                            wattroff(pField, COLOR_PAIR(val - '0'));
+                            generator_recycle(
+                                board[focus]->adopt_backing(prepared));
                         }
-                    }
-                    else if (val == '0')
-                    {
-                        // Revealed cells with no neighboring mines
-                        mvwaddch(pField, y, x, ' ');
-                    }
-                    else
-                    {
-                        // The mines hit
-                        mvwaddch(pField, y, x, val);
+                        break;
                     }
                 }
-                else
-                {
-                    // Unrevealed cells
-                    mvwaddch(pField, y, x, '.');
-                }
             }
+
+            wtimeout(pScore, 0);
+            key = wgetch(pScore);
+            wtimeout(pScore, tick);
         }
 
-        // If the player has lost, reveal the locations of all the mines
-        if (lose)
+        if (dy != 0 || dx != 0)
         {
-            // Iterate over all the cells in the mine field
-            for (TCell h = 0 ; h < height ; ++h)
-            {
-                for (TCell w = 0 ; w < width ; ++w)
-                {
-                    // Grab the mine value and the player input value
-                    const TCell val = get(h, w);
-                    const TCell ival = geti(h, w);
-
-                    // If the cell contains a mine
-                    if (val == MINE)
-                    {
-                        // If the cell was not flagged by the player
-                        if (ival != FLAGGED)
-                        {
-                            if (has_colors() && (curY == h) && (curX == w))
-                            {
-                                wattron(pField, COLOR_PAIR(3));
-                            }
+            board[focus]->move_cur(dy, dx);
+        }
 
-                            // Indicate to the player the location of the mine
-                            mvwaddch(pField, h, w, MINE);
+        // Stage every window once, the focused board last so the
+        // terminal cursor lands on it, then flush in one doupdate
+        board[focus]->update_score();
+        mvwprintw(pScore, 10, 0, "Board: %d / %d    [tab] Switch",
+                  focus + 1, boards);
+        wnoutrefresh(pScore);
 
-                            if (has_colors() && (curY == h) && (curX == w))
-                            {
-                                wattroff(pField, COLOR_PAIR(3));
-                            }
-                        }
-                    }
-                    
-                    // Indicate an incorrectly placed flag
-                    if (val != MINE && ival == FLAGGED)
-                    {
-                        mvwaddch(pField, h, w, WRONG_FLAG);
-                    }
-                }
+        for (int b = 0 ; b < boards ; ++b)
+        {
+            if (b != focus)
+            {
+                board[b]->update_field();
             }
         }
 
-        // Move the cursor back to the correct place and refresh the window
-        wmove(pField, curY, curX);
-        wrefresh(pField);
+        board[focus]->update_field();
+        doupdate();
     }
 
-    //
-    // Update the score window view
-    //
-    void update_score()
-    {
-        // Grab the current time, and calculate the delta since the start of
-        // the game
-        struct timespec curTime;
-        clock_gettime(CLOCK_MONOTONIC_RAW, &curTime);
-        uint64_t delta_ms = ((curTime.tv_sec - startTime.tv_sec) * 1000000 +
-                            (curTime.tv_nsec - startTime.tv_nsec) / 1000) / 1000;
+    generator_stop();
 
-        // If no cells have been revealed yet, don't show any time delta
-        if (revealCount == 0)
+    endwin();
+
+    prof_dump();
+
+    // Fold every finished board into the persistent statistics
+    for (int b = 0 ; b < boards ; ++b)
+    {
+        if (board[b]->is_win() || board[b]->is_lose())
         {
-            delta_ms = 0;
+            stats_record_game(height, width, mines, board[b]->is_win(),
+                              board[b]->elapsed_ms(),
+                              board[b]->get_reveal_count(),
+                              board[b]->get_flag_count());
         }
 
-        // Print the scoreboard window
-        mvwprintw(pScore, 1, 0, "         Minesweeper");
-        mvwprintw(pScore, 3, 0, " [h] Move Left   [l] Move Right");
-        mvwprintw(pScore, 4, 0, " [j] Move Down   [k] Move Up");
-        mvwprintw(pScore, 5, 0, " [f] Flag Mine   [q] Quit");
-        mvwprintw(pScore, 6, 0, " [space] Reveal");
-        wmove(pScore, 8, 0);
-        wclrtoeol(pScore);
-        mvwprintw(pScore, 8, 0, "Flags: %2d / %2d  Status: %s", flagCount, mines, status());
-        wmove(pScore, 9, 0);
-        wclrtoeol(pScore);
-        mvwprintw(pScore, 9, 0, "Time: %d ms", delta_ms);
-
-        wrefresh(pScore);
+        delete board[b];
     }
 
-    // Return a string representation of the outcome of the game
-    const char * status() const
-    {
-        if (lose)
-            return STR_LOSE;
-        if (win)
-            return STR_WIN;
-        if (done)
-            return STR_ABORTED;
+    free(board);
+    free(pField);
+}
 
-        return STR_PLAYING;
+#ifdef MS_BENCH
+
+//
+// Benchmark driver, built via `make bench`. Times the subsystems in
+// isolation: reset() (mine placement plus neighbor counting) across board
+// sizes and densities, the flood-fill reveal engine on worst-case
+// all-zero boards, and update_field against a null ncurses screen.
+// Reports ns/cell and cells/sec for each.
+//
+
+//
+// Current monotonic time in nanoseconds
+//
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+//
+// Print one benchmark result line
+//
+static void bench_report(const char * const name,
+                         const TIndex height, const TIndex width,
+                         const TIndex mines,
+                         const uint64_t elapsed_ns, const long iters)
+{
+    const double cells = (double) height * (double) width * (double) iters;
+    const double nsPerCell = (double) elapsed_ns / cells;
+    const double cellsPerSec = cells * 1e9 / (double) elapsed_ns;
+
+    printf("%-12s %4d x %-4d mines=%-6d  %8.2f ns/cell  %12.0f cells/sec\n",
+           name, width, height, mines, nsPerCell, cellsPerSec);
+}
+
+//
+// Time reset() (placement + neighbor counting)
+//
+template <typename TB>
+void bench_reset(const char * const name, const TIndex height,
+                 const TIndex width, const TIndex mines, const long iters)
+{
+    TB board(height, width, mines, NULL, NULL);
+
+    const uint64_t t0 = now_ns();
+
+    for (long i = 0 ; i < iters ; ++i)
+    {
+        board.reset();
     }
-};
+
+    bench_report(name, height, width, mines, now_ns() - t0, iters);
+}
 
 //
-// Play through the mine sweeper game
+// Time the flood-fill reveal engine on a worst-case all-zero board,
+// where a single reveal cascades across every cell
 //
-void minesweeper(const TCell height, const TCell width, const TCell mines)
+void bench_flood(const TIndex height, const TIndex width, const long iters)
 {
-    // Initialize ncurses
-    initscr();
+    SBoard board(height, width, 0, NULL, NULL);
+    uint64_t elapsed = 0;
 
-    // If the terminal supports colors, initialize color pairs
-    if (has_colors())
+    for (long i = 0 ; i < iters ; ++i)
     {
-        start_color();
-        init_pair(1, COLOR_BLUE, COLOR_BLACK);
-        init_pair(2, COLOR_GREEN, COLOR_BLACK);
-        init_pair(3, COLOR_RED, COLOR_BLACK);
-        init_pair(4, COLOR_MAGENTA, COLOR_BLACK);
-        init_pair(5, COLOR_RED, COLOR_BLACK);
-        init_pair(6, COLOR_CYAN, COLOR_BLACK);
-        init_pair(7, COLOR_WHITE, COLOR_BLACK);
-        init_pair(8, COLOR_WHITE, COLOR_BLACK);
+        board.reset();
+        board.set_cur(0, 0);
+
+        const uint64_t t0 = now_ns();
+        board.reveal();
+        elapsed += now_ns() - t0;
     }
 
-    // Ncurses setings
-    cbreak();
-    noecho();
+    bench_report("flood", height, width, 0, elapsed, iters);
+}
 
-    // Ncurses windows for the scoreboard and mine field
-    WINDOW * pScore = newwin(11, 31, 1, 1);
-    WINDOW * pField = newwin(height, width, 12, 1);
+//
+// Time update_field full redraws against a null ncurses screen (a real
+// curses session whose output goes to /dev/null)
+//
+void bench_update(const TIndex height, const TIndex width, const TIndex mines,
+                  const long iters)
+{
+    FILE * devnull = fopen("/dev/null", "w");
+    SCREEN * screen = newterm(getenv("TERM") ? NULL : (char *) "xterm",
+                              devnull, stdin);
 
-    // Create the mine sweeper board and update the view
-    SBoard board(height, width, mines, pScore, pField);
-    board.update();
+    if (screen == NULL)
+    {
+        printf("%-12s skipped (no usable terminal)\n", "update_field");
+        fclose(devnull);
+        return;
+    }
 
-    // Set a timeout for input, so the timer/clock updates automatically
-    nodelay(pField, true);
-    wtimeout(pField, 1000);
+    // Clamp the window to the null screen like the real game does, so
+    // oversized boards exercise the scrolling viewport path
+    int fieldHeight = (int) height < LINES ? (int) height : LINES;
+    int fieldWidth = (int) width < COLS ? (int) width : COLS;
 
-    // Main Loop
-    while (!board.is_done())
+    WINDOW * pField = newwin(fieldHeight, fieldWidth, 0, 0);
+    SBoard board(height, width, mines, NULL, pField);
+    uint64_t elapsed = 0;
+
+    for (long i = 0 ; i < iters ; ++i)
     {
-        int key = wgetch(pField);
-        switch (key)
-        {
-            case KEY_DOWN:
-            case 'j':
-                board.move_cur(1, 0);
-                break;
-            case KEY_UP:
-            case 'k':
-                board.move_cur(-1, 0);
-                break;
-            case KEY_LEFT:
-            case 'h':
-                board.move_cur(0, -1);
-                break;
-            case KEY_RIGHT:
-            case 'l':
-                board.move_cur(0, 1);
-                break;
-            case ' ':
-                board.reveal();
-                break;
-            case 'f':
-                board.flag();
-                break;
-            case 'q':
-                board.quit();
-                break;
-        }
+        // reset() forces the next update_field to redraw every cell
+        board.reset();
 
-        // Update the board view
-        board.update();
+        const uint64_t t0 = now_ns();
+        board.update_field();
+        elapsed += now_ns() - t0;
     }
 
-    // Ncurses end
+    delwin(pField);
     endwin();
+    delscreen(screen);
+    fclose(devnull);
+
+    bench_report("update_field", height, width, mines, elapsed, iters);
+}
+
+//
+// Benchmark main. Runs every subsystem benchmark with a fixed seed so
+// runs are comparable.
+//
+int main(int argc, char * argv[])
+{
+    select_kernels();
+    seed_random(12345);
+
+    bench_reset<SBoard>("reset", 8, 8, 10, 200000);
+    bench_reset<SBoard>("reset", 16, 30, 99, 50000);
+    bench_reset<SBoard>("reset", 200, 200, 4000, 500);
+    bench_reset<SBoard>("reset", 500, 500, 100000, 50);
+
+    // The compile-time specialized preset variants, against the
+    // runtime-sized rows above
+    bench_reset<SBoardBeginner>("reset<8x8>", 8, 8, 10, 200000);
+    bench_reset<SBoardIntermediate>("reset<16x16>", 16, 16, 40, 100000);
+    bench_reset<SBoardExpert>("reset<16x30>", 16, 30, 99, 50000);
+
+    bench_flood(16, 30, 20000);
+    bench_flood(200, 200, 500);
+    bench_flood(500, 500, 50);
+
+    bench_update(16, 30, 99, 20000);
+    bench_update(100, 100, 1000, 500);
+
+    return EXIT_SUCCESS;
 }
 
+#else // MS_BENCH
+
 //
 // Main function. Starts a minesweeper game in beginner mode by default.
 //
 int main(int argc, char * argv[])
 {
     // Command line option handling
-    bool bFlag = false;
-    bool iFlag = false;
-    bool eFlag = false;
+    int presetIdx = -1;
     bool flagErr = false;
     int flagCount = 0;
     int opt;
 
-    while ((opt = getopt(argc, argv, "bie")) != -1)
+    // Custom board geometry (overrides the preset modes when given)
+    TIndex customHeight = 0;
+    TIndex customWidth = 0;
+    TIndex customMines = 0;
+
+    // Number of headless games to simulate (0 means interactive play)
+    long headlessGames = 0;
+
+    // Deterministic PRNG seed, for reproducible boards
+    bool seedGiven = false;
+    uint64_t seed = 0;
+
+    // Number of worker threads for headless simulation
+    int threads = 1;
+
+    // Replay recording and playback
+    const char * recordPath = NULL;
+    const char * replayPath = NULL;
+    bool replayFast = false;
+
+    // Input timeout in milliseconds, which sets how often the score
+    // clock repaints while the game is idle
+    int tick = 1000;
+
+    // Snapshot save path and restore file
+    const char * snapshotPath = "minesweeper.snap";
+    const char * restorePath = NULL;
+
+    // Let the built-in solver play the interactive game
+    bool autoplay = false;
+
+    // Persistent statistics file, and whether to just print its totals
+    const char * statsPath = NULL;
+    bool statsShow = false;
+
+    // Number of side-by-side boards in one session
+    int boards = 1;
+
+    static const struct option longOptions[] =
+    {
+        { "headless", required_argument, NULL, 'H' },
+        { "record", required_argument, NULL, 'R' },
+        { "replay", required_argument, NULL, 'P' },
+        { "replay-fast", no_argument, NULL, 'F' },
+        { "snapshot", required_argument, NULL, 'S' },
+        { "restore", required_argument, NULL, 'O' },
+        { "autoplay", no_argument, NULL, 'A' },
+        { "grade", required_argument, NULL, 'G' },
+        { "boards", required_argument, NULL, 'B' },
+        { "stats", required_argument, NULL, 'T' },
+        { "stats-show", required_argument, NULL, 'W' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    while ((opt = getopt_long(argc, argv, "bieg:w:h:m:s:j:t:", longOptions, NULL)) != -1)
     {
         switch (opt)
         {
             // Beginner mode
             case 'b':
-                bFlag = true;
+                presetIdx = 0;
                 ++flagCount;
                 break;
             // Intermediate mode
             case 'i':
-                iFlag = true;
+                presetIdx = 1;
                 ++flagCount;
                 break;
             // Expert mode
             case 'e':
-                eFlag = true;
+                presetIdx = 2;
                 ++flagCount;
                 break;
+            // Full geometry in one option
+            case 'g':
+            {
+                int gh = 0;
+                int gw = 0;
+                int gm = 0;
+
+                if (sscanf(optarg, "%dx%dx%d", &gh, &gw, &gm) != 3)
+                {
+                    flagErr = true;
+                }
+                else
+                {
+                    customHeight = (TIndex) gh;
+                    customWidth = (TIndex) gw;
+                    customMines = (TIndex) gm;
+                }
+                break;
+            }
+            // Custom board width
+            case 'w':
+                customWidth = (TIndex) atol(optarg);
+                break;
+            // Custom board height
+            case 'h':
+                customHeight = (TIndex) atol(optarg);
+                break;
+            // Custom number of mines
+            case 'm':
+                customMines = (TIndex) atol(optarg);
+                break;
+            // Headless batch simulation
+            case 'H':
+                headlessGames = atol(optarg);
+                break;
+            // Deterministic PRNG seed
+            case 's':
+                seedGiven = true;
+                seed = strtoull(optarg, NULL, 0);
+                break;
+            // Record the game to a replay log
+            case 'R':
+                recordPath = optarg;
+                break;
+            // Play back a replay log
+            case 'P':
+                replayPath = optarg;
+                break;
+            // Play back without the recorded timing
+            case 'F':
+                replayFast = true;
+                break;
+            // Snapshot save path
+            case 'S':
+                snapshotPath = optarg;
+                break;
+            // Resume from a snapshot
+            case 'O':
+                restorePath = optarg;
+                break;
+            // Solver-driven interactive play
+            case 'A':
+                autoplay = true;
+                break;
+            // Grade the geometry: solver win rate over N headless games
+            case 'G':
+                headlessGames = atol(optarg);
+                headlessSolver = true;
+                break;
+            // Side-by-side concurrent boards
+            case 'B':
+                boards = atoi(optarg);
+                if (boards < 1 || boards > 8)
+                {
+                    flagErr = true;
+                }
+                break;
+            // Persistent statistics file
+            case 'T':
+                statsPath = optarg;
+                break;
+            // Print lifetime statistics and exit
+            case 'W':
+                statsPath = optarg;
+                statsShow = true;
+                break;
+            // Idle clock tick in milliseconds
+            case 't':
+                tick = atoi(optarg);
+                if (tick < 1)
+                {
+                    flagErr = true;
+                }
+                break;
+            // Worker threads for headless simulation
+            case 'j':
+                threads = atoi(optarg);
+                if (threads < 1)
+                {
+                    flagErr = true;
+                }
+                break;
             default:
                 flagErr = true;
                 break;
         }
     }
 
+    // Custom geometry requires all three dimensions (either -g, or all
+    // of -w, -h, and -m), cannot be combined with a preset mode, and
+    // must fit the limits of the index type
+    const bool customFlag = (customHeight != 0 || customWidth != 0 ||
+                             customMines != 0);
+
+    if (customFlag)
+    {
+        if (flagCount > 0 ||
+            !valid_geometry(customHeight, customWidth, customMines))
+        {
+            flagErr = true;
+        }
+    }
+
+    // Multi-board sessions drive every board from one live input loop,
+    // which does not compose with recording, replay, restore, or the
+    // solver
+    if (boards > 1 &&
+        (recordPath != NULL || replayPath != NULL || restorePath != NULL ||
+         autoplay))
+    {
+        flagErr = true;
+    }
+
     // Check for invalid command line options
     if (flagErr || flagCount > 1)
     {
-        fprintf(stderr, "Usage: %s [-b|-i|-e]\n", argv[0]);
-        fprintf(stderr, "    -b    Beginner       8 x 8  grid with 10 mines\n");
-        fprintf(stderr, "    -i    Intermediate  16 x 16 grid with 40 mines\n");
-        fprintf(stderr, "    -e    Expert        16 x 30 grid with 99 mines\n");
+        fprintf(stderr, "Usage: %s [-b|-i|-e] [-g HxWxM] [-s seed] [--headless games]\n", argv[0]);
+
+        for (size_t p = 0 ; p < sizeof(PRESETS) / sizeof(PRESETS[0]) ; ++p)
+        {
+            fprintf(stderr, "    -%c    %-13s %2d x %-2d grid with %d mines\n",
+                    "bie"[p], PRESETS[p].name,
+                    PRESETS[p].height, PRESETS[p].width, PRESETS[p].mines);
+        }
+
+        fprintf(stderr, "    -g    Custom geometry as HEIGHTxWIDTHxMINES\n");
+        fprintf(stderr, "    -h    Custom board height\n");
+        fprintf(stderr, "    -w    Custom board width\n");
+        fprintf(stderr, "    -m    Custom number of mines\n");
+        fprintf(stderr, "    -s    Deterministic random seed (reproducible boards)\n");
+        fprintf(stderr, "    -t    Idle clock tick in milliseconds (default 1000)\n");
+        fprintf(stderr, "    -j    Worker threads for headless simulation\n");
+        fprintf(stderr, "    --headless games  Simulate games without a terminal\n");
+        fprintf(stderr, "    --record file     Record the game to a replay log\n");
+        fprintf(stderr, "    --replay file     Play back a replay log\n");
+        fprintf(stderr, "    --replay-fast     Replay at full speed\n");
+        fprintf(stderr, "    --snapshot file   Path for in-game [S] snapshots\n");
+        fprintf(stderr, "    --restore file    Resume a snapshot\n");
+        fprintf(stderr, "    --autoplay        Let the built-in solver play\n");
+        fprintf(stderr, "    --grade games     Solver win rate over N headless games\n");
+        fprintf(stderr, "    --boards n        Play n boards side by side (tab switches)\n");
+        fprintf(stderr, "    --stats file      Log finished games to a statistics file\n");
+        fprintf(stderr, "    --stats-show file Print lifetime statistics and exit\n");
+        return EXIT_FAILURE;
+    }
+
+    // Resolve the board geometry from the preset table (beginner by
+    // default) or the custom options
+    TIndex height = PRESETS[0].height;
+    TIndex width = PRESETS[0].width;
+    TIndex mines = PRESETS[0].mines;
+
+    if (customFlag)
+    {
+        // Custom sized board
+        height = customHeight;
+        width = customWidth;
+        mines = customMines;
+    }
+    else if (presetIdx >= 0)
+    {
+        height = PRESETS[presetIdx].height;
+        width = PRESETS[presetIdx].width;
+        mines = PRESETS[presetIdx].mines;
+    }
+
+    // A replay log overrides the geometry and the seed, so the board
+    // reconstructs identically
+    FILE * replayFile = NULL;
+
+    if (replayPath != NULL)
+    {
+        replayFile = fopen(replayPath, "rb");
+
+        SReplayHeader header;
+
+        if (replayFile == NULL ||
+            fread(&header, sizeof(header), 1, replayFile) != 1 ||
+            header.magic != REPLAY_MAGIC ||
+            header.version != REPLAY_VERSION ||
+            !valid_geometry(header.height, header.width, header.mines))
+        {
+            fprintf(stderr, "%s: invalid replay log: %s\n", argv[0], replayPath);
+            return EXIT_FAILURE;
+        }
+
+        height = header.height;
+        width = header.width;
+        mines = header.mines;
+        seed = header.seed;
+        seedGiven = true;
+    }
+
+    // A snapshot carries its own geometry; the board state comes from
+    // the file, so the mine layout does not depend on the seed
+    FILE * restoreFile = NULL;
+    SSnapshotHeader restoreHeader;
+
+    if (restorePath != NULL)
+    {
+        restoreFile = fopen(restorePath, "rb");
+
+        if (restoreFile == NULL ||
+            fread(&restoreHeader, sizeof(restoreHeader), 1, restoreFile) != 1 ||
+            restoreHeader.magic != SNAPSHOT_MAGIC ||
+            restoreHeader.version != SNAPSHOT_VERSION ||
+            !valid_geometry(restoreHeader.height, restoreHeader.width,
+                            restoreHeader.mines))
+        {
+            fprintf(stderr, "%s: invalid snapshot: %s\n", argv[0], restorePath);
+            return EXIT_FAILURE;
+        }
+
+        height = restoreHeader.height;
+        width = restoreHeader.width;
+        mines = restoreHeader.mines;
+    }
+
+    // Open the persistent statistics file, if one was asked for
+    if (statsPath != NULL && !stats_open(statsPath))
+    {
+        fprintf(stderr, "%s: cannot open stats file: %s\n", argv[0], statsPath);
         return EXIT_FAILURE;
     }
 
-    // Seed randomizer with current time
-    srand(time(0));
+    // Just report the lifetime totals: an O(1) read of the mapped
+    // aggregate header, independent of how many games were logged
+    if (statsShow)
+    {
+        stats_print();
+        stats_close();
+        return EXIT_SUCCESS;
+    }
+
+    // Pick the CPU-appropriate compute kernels
+    select_kernels();
+
+    // Seed the randomizer, with the current time unless a deterministic
+    // seed was given on the command line (or taken from a replay log)
+    if (!seedGiven)
+    {
+        seed = (uint64_t) time(0);
+    }
+
+    seed_random(seed);
 
-    if (bFlag || flagCount == 0)
+    if (headlessGames > 0)
     {
-        // Play beginner mode
-        minesweeper(8, 8, 10);
+        // Simulate a batch of games without any terminal output
+        headless(height, width, mines, headlessGames, threads);
     }
-    else if (iFlag)
+    else if (boards > 1)
     {
-        // Play intermediate mode
-        minesweeper(16, 16, 40);
+        // Play several boards in one session
+        minesweeper_multi(height, width, mines, boards, tick);
     }
-    else if (eFlag)
+    else
     {
-        // Play expert mode
-        minesweeper(16, 30, 99);
+        // Play the game interactively
+        minesweeper(height, width, mines, seed, recordPath, replayFile,
+                    replayFast, tick, snapshotPath,
+                    (restoreFile != NULL) ? &restoreHeader : NULL,
+                    restoreFile, autoplay);
+    }
+
+    stats_close();
+
+    if (replayFile != NULL)
+    {
+        fclose(replayFile);
+    }
+
+    if (restoreFile != NULL)
+    {
+        fclose(restoreFile);
     }
 
     return EXIT_SUCCESS;
 }
 
-
+#endif // MS_BENCH